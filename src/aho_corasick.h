@@ -0,0 +1,283 @@
+#ifndef GRAPHFAST_AHO_CORASICK_H
+#define GRAPHFAST_AHO_CORASICK_H
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include "utf8_fold.h"
+
+// Aho-Corasick automaton over bytes (Aho & Corasick, 1975).
+//
+// Every string is scanned once regardless of the number of patterns. The
+// goto function is stored flat: a dense 256-entry row for the root and for
+// states with many children, and sorted (label, target) arrays for the rest,
+// which keeps deep, sparse states small and the hot top of the trie in a
+// few cache lines. Missing transitions follow failure links.
+//
+// `fold` maps every byte before it enters the automaton, both when the
+// patterns are inserted and when text is scanned, which is how
+// case-insensitive matching works without copying the text. With `utf8`,
+// multi-byte characters in the text are additionally case folded one
+// character at a time (see utf8_fold.h); the patterns must then be folded
+// with fold_utf8 beforehand.
+class AhoCorasick {
+public:
+    static const int DENSE_MIN_CHILDREN = 16;
+
+    AhoCorasick() : n_patterns_(0), max_length_(0), has_empty_(false), utf8_(false) {
+        for (int c = 0; c < 256; c++) fold_[c] = static_cast<uint8_t>(c);
+    }
+
+    // patterns are raw bytes; fold may be null for the identity
+    void build(const std::vector<std::string>& patterns, const uint8_t* fold, bool utf8 = false) {
+        utf8_ = utf8;
+        n_patterns_ = static_cast<int>(patterns.size());
+        max_length_ = 0;
+        has_empty_ = false;
+        for (int c = 0; c < 256; c++) fold_[c] = fold ? fold[c] : static_cast<uint8_t>(c);
+
+        // Trie with per-state child lists
+        std::vector<std::vector<std::pair<uint8_t, int>>> children(1);
+        std::vector<std::vector<int>> own(1);
+        depth_.assign(1, 0);
+
+        for (int p = 0; p < n_patterns_; p++) {
+            const std::string& pattern = patterns[p];
+            if (pattern.empty()) has_empty_ = true;
+            max_length_ = std::max(max_length_, static_cast<int>(pattern.size()));
+            int s = 0;
+            for (size_t i = 0; i < pattern.size(); i++) {
+                uint8_t c = fold_[static_cast<uint8_t>(pattern[i])];
+                int next = -1;
+                for (size_t k = 0; k < children[s].size(); k++) {
+                    if (children[s][k].first == c) {
+                        next = children[s][k].second;
+                        break;
+                    }
+                }
+                if (next < 0) {
+                    next = static_cast<int>(children.size());
+                    children[s].push_back(std::make_pair(c, next));
+                    children.push_back(std::vector<std::pair<uint8_t, int>>());
+                    own.push_back(std::vector<int>());
+                    depth_.push_back(depth_[s] + 1);
+                }
+                s = next;
+            }
+            own[s].push_back(p);
+        }
+
+        const int n_states = static_cast<int>(children.size());
+
+        // Flatten the goto function
+        edge_begin_.assign(static_cast<size_t>(n_states) + 1, 0);
+        dense_row_.assign(n_states, -1);
+        edge_label_.clear();
+        edge_target_.clear();
+        dense_.clear();
+        for (int s = 0; s < n_states; s++) {
+            std::sort(children[s].begin(), children[s].end());
+            if (s == 0 || static_cast<int>(children[s].size()) >= DENSE_MIN_CHILDREN) {
+                dense_row_[s] = static_cast<int>(dense_.size() / 256);
+                dense_.resize(dense_.size() + 256, -1);
+                for (size_t k = 0; k < children[s].size(); k++) {
+                    dense_[dense_row_[s] * 256 + children[s][k].first] = children[s][k].second;
+                }
+            }
+            for (size_t k = 0; k < children[s].size(); k++) {
+                edge_label_.push_back(children[s][k].first);
+                edge_target_.push_back(children[s][k].second);
+            }
+            edge_begin_[s + 1] = static_cast<int>(edge_label_.size());
+        }
+
+        // Failure and dictionary-suffix links, breadth first
+        fail_.assign(n_states, 0);
+        dict_link_.assign(n_states, -1);
+        std::vector<int> queue;
+        queue.reserve(n_states);
+        for (size_t k = 0; k < children[0].size(); k++) queue.push_back(children[0][k].second);
+
+        for (size_t head = 0; head < queue.size(); head++) {
+            int s = queue[head];
+            int f = fail_[s];
+            dict_link_[s] = own[f].empty() ? dict_link_[f] : f;
+            for (size_t k = 0; k < children[s].size(); k++) {
+                uint8_t c = children[s][k].first;
+                int t = children[s][k].second;
+                fail_[t] = s == 0 ? 0 : step(f, c);
+                queue.push_back(t);
+            }
+        }
+        dict_link_[0] = -1;
+
+        // Outputs
+        out_begin_.assign(static_cast<size_t>(n_states) + 1, 0);
+        out_pattern_.clear();
+        terminal_.assign(n_states, 0);
+        for (int s = 0; s < n_states; s++) {
+            out_pattern_.insert(out_pattern_.end(), own[s].begin(), own[s].end());
+            out_begin_[s + 1] = static_cast<int>(out_pattern_.size());
+        }
+        for (size_t k = 0; k < queue.size(); k++) {
+            int s = queue[k];
+            terminal_[s] = (!own[s].empty() || dict_link_[s] >= 0) ? 1 : 0;
+        }
+    }
+
+    int n_patterns() const { return n_patterns_; }
+    int n_states() const { return static_cast<int>(fail_.size()); }
+    bool has_empty_pattern() const { return has_empty_; }
+    const uint8_t* fold() const { return fold_; }
+
+    double memory_bytes() const {
+        return static_cast<double>(
+            dense_.size() * sizeof(int) + edge_label_.size() + edge_target_.size() * sizeof(int) +
+            (edge_begin_.size() + dense_row_.size() + fail_.size() + dict_link_.size() +
+             out_begin_.size() + out_pattern_.size() + depth_.size()) * sizeof(int) +
+            terminal_.size());
+    }
+
+    // Next state after reading byte c (already folded) in state s
+    int step(int s, uint8_t c) const {
+        for (;;) {
+            int t = child(s, c);
+            if (t >= 0) return t;
+            if (s == 0) return 0;
+            s = fail_[s];
+        }
+    }
+
+    // True if any pattern occurs in text; stops at the first match
+    bool contains_any(const char* text, size_t len) const {
+        if (has_empty_) return true;
+        if (utf8_) {
+            StopAtFirst f = { false };
+            scan(text, len, f);
+            return f.found;
+        }
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(text);
+        int s = 0;
+        for (size_t i = 0; i < len; i++) {
+            s = step(s, fold_[p[i]]);
+            if (terminal_[s]) return true;
+        }
+        return false;
+    }
+
+    // Calls f(pattern, end) for every occurrence, where end is one past the
+    // last byte of the match. Occurrences are reported in order of end
+    // position; empty patterns are reported at every position.
+    template <class F>
+    void for_each_match(const char* text, size_t len, F& f) const {
+        ContinueAlways<F> g = { f };
+        scan(text, len, g);
+    }
+
+    // As for_each_match, but f returns false to stop the scan
+    template <class F>
+    void scan(const char* text, size_t len, F& f) const {
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(text);
+        int s = 0;
+        if (has_empty_ && !emit(0, 0, f)) return;
+        if (!utf8_) {
+            for (size_t i = 0; i < len; i++) {
+                s = step(s, fold_[p[i]]);
+                if ((terminal_[s] || has_empty_) && !emit(s, i + 1, f)) return;
+            }
+            return;
+        }
+
+        uint8_t folded[4];
+        for (size_t i = 0; i < len;) {
+            if (p[i] < 0x80) {
+                s = step(s, fold_[p[i]]);
+                i++;
+                if ((terminal_[s] || has_empty_) && !emit(s, i, f)) return;
+                continue;
+            }
+            int n = fold_utf8_char(p + i, len - i, folded);
+            if (n == 0) {
+                folded[0] = p[i];
+                n = 1;
+            }
+            for (int k = 0; k < n; k++) {
+                s = step(s, folded[k]);
+                if ((terminal_[s] || has_empty_) && !emit(s, i + k + 1, f)) return;
+            }
+            i += n;
+        }
+    }
+
+    // Length of the pattern ending in state s
+    int depth(int s) const { return depth_[s]; }
+
+    int max_pattern_length() const { return max_length_; }
+
+private:
+    int n_patterns_;
+    int max_length_;
+    bool has_empty_;
+    bool utf8_;
+    uint8_t fold_[256];
+
+    std::vector<int> dense_;        // 256 entries per dense row, -1 = no child
+    std::vector<int> dense_row_;    // per state, -1 if sparse
+    std::vector<int> edge_begin_;   // per state, into edge_label_/edge_target_
+    std::vector<uint8_t> edge_label_;
+    std::vector<int> edge_target_;
+    std::vector<int> fail_;
+    std::vector<int> dict_link_;    // nearest proper suffix state with an output
+    std::vector<int> out_begin_;    // per state, into out_pattern_
+    std::vector<int> out_pattern_;
+    std::vector<int> depth_;
+    std::vector<uint8_t> terminal_; // state or a suffix of it ends a pattern
+
+    int child(int s, uint8_t c) const {
+        int row = dense_row_[s];
+        if (row >= 0) return dense_[row * 256 + c];
+        int lo = edge_begin_[s], hi = edge_begin_[s + 1];
+        if (hi - lo <= 8) {
+            for (int k = lo; k < hi; k++) {
+                if (edge_label_[k] == c) return edge_target_[k];
+            }
+            return -1;
+        }
+        const uint8_t* first = edge_label_.data() + lo;
+        const uint8_t* last = edge_label_.data() + hi;
+        const uint8_t* it = std::lower_bound(first, last, c);
+        return (it != last && *it == c) ? edge_target_[lo + (it - first)] : -1;
+    }
+
+    struct StopAtFirst {
+        bool found;
+        bool operator()(int, size_t) {
+            found = true;
+            return false;
+        }
+    };
+
+    template <class F>
+    struct ContinueAlways {
+        F& f;
+        bool operator()(int pattern, size_t end) {
+            f(pattern, end);
+            return true;
+        }
+    };
+
+    template <class F>
+    bool emit(int s, size_t end, F& f) const {
+        for (int t = s; t >= 0; t = dict_link_[t]) {
+            for (int k = out_begin_[t]; k < out_begin_[t + 1]; k++) {
+                if (!f(out_pattern_[k], end)) return false;
+            }
+            if (t == 0) break;
+        }
+        return true;
+    }
+};
+
+#endif
@@ -0,0 +1,234 @@
+#ifndef GRAPHFAST_APPROX_MATCHER_H
+#define GRAPHFAST_APPROX_MATCHER_H
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include "aho_corasick.h"
+
+// Approximate multi-pattern matching: a pattern matches if some substring
+// of the text is within max_distance edits (insertions, deletions,
+// substitutions of bytes) of it.
+//
+// Filter and verify. By the pigeonhole principle, a pattern cut into k + 1
+// pieces that occurs with at most k edits contains at least one piece
+// unchanged, so all pieces of all patterns go into one Aho-Corasick
+// automaton and the text is scanned once. Every piece hit selects a window
+// of the text around it, which is verified with Myers' bit-parallel
+// algorithm (Myers, 1999) for patterns of up to 64 bytes and with
+// Ukkonen's cut-off dynamic program for longer ones. Patterns whose pieces
+// would be shorter than MIN_PIECE bytes make a poor filter and are verified
+// against the whole text instead.
+class ApproxMatcher {
+public:
+    static const int MIN_PIECE = 2;
+
+    // Per-thread state reused across strings
+    struct Scratch {
+        std::vector<uint32_t> stamp;    // per pattern: last string that reached it
+        std::vector<uint8_t> matched;   // per pattern, valid if stamped
+        std::vector<size_t> from, to;   // per pattern: last verified window
+        std::vector<int> column;        // dynamic-programming column
+        uint32_t current;
+
+        Scratch() : current(0) {}
+    };
+
+    ApproxMatcher(const std::vector<std::string>& patterns, int max_distance, bool ignore_case)
+        : k_(max_distance) {
+        for (int c = 0; c < 256; c++) {
+            fold_[c] = static_cast<uint8_t>(ignore_case && c >= 'A' && c <= 'Z' ? c + 32 : c);
+        }
+
+        const int n = static_cast<int>(patterns.size());
+        patterns_.resize(n);
+        peq_offset_.assign(n, -1);
+        std::vector<std::string> pieces;
+        for (int p = 0; p < n; p++) {
+            std::string& pattern = patterns_[p];
+            pattern = patterns[p];
+            for (size_t i = 0; i < pattern.size(); i++) pattern[i] = static_cast<char>(fold_[static_cast<uint8_t>(pattern[i])]);
+            const int m = static_cast<int>(pattern.size());
+
+            if (m <= k_) {
+                trivial_.push_back(p);
+                continue;
+            }
+            if (m <= 64) {
+                peq_offset_[p] = static_cast<int>(peq_.size());
+                peq_.resize(peq_.size() + 256, 0);
+                uint64_t* peq = &peq_[peq_offset_[p]];
+                for (int i = 0; i < m; i++) peq[static_cast<uint8_t>(pattern[i])] |= uint64_t(1) << i;
+            }
+            if (m / (k_ + 1) < MIN_PIECE) {
+                unfiltered_.push_back(p);
+                continue;
+            }
+            for (int j = 0, start = 0; j <= k_; j++) {
+                const int end = static_cast<int>(static_cast<int64_t>(m) * (j + 1) / (k_ + 1));
+                pieces.push_back(pattern.substr(start, end - start));
+                piece_pattern_.push_back(p);
+                piece_offset_.push_back(start);
+                piece_length_.push_back(end - start);
+                start = end;
+            }
+        }
+        // Pieces are already folded
+        filter_.build(pieces, NULL);
+    }
+
+    int n_patterns() const { return static_cast<int>(patterns_.size()); }
+    int max_distance() const { return k_; }
+
+    // True if any pattern occurs within max_distance edits
+    bool any(const char* text, size_t len, Scratch& scratch) const {
+        StopAtFirst f;
+        scan(text, len, scratch, f);
+        return f.found;
+    }
+
+    // Calls f(pattern) once for every pattern occurring within max_distance
+    // edits; f returns false to stop
+    template <class F>
+    void scan(const char* text, size_t len, Scratch& scratch, F& f) const {
+        begin(scratch);
+        for (size_t t = 0; t < trivial_.size(); t++) {
+            if (!f(trivial_[t])) return;
+        }
+        for (size_t u = 0; u < unfiltered_.size(); u++) {
+            const int p = unfiltered_[u];
+            if (verify(p, text, len, scratch) && !f(p)) return;
+        }
+        if (!piece_pattern_.empty()) {
+            Candidates<F> hits = { this, text, len, &scratch, &f };
+            filter_.scan(text, len, hits);
+        }
+    }
+
+private:
+    int k_;
+    uint8_t fold_[256];
+    std::vector<std::string> patterns_;   // folded
+    std::vector<int> peq_offset_;         // per pattern into peq_, -1 if longer than 64
+    std::vector<uint64_t> peq_;           // Myers match masks, 256 per pattern
+    std::vector<int> trivial_;            // no longer than max_distance: always match
+    std::vector<int> unfiltered_;
+    std::vector<int> piece_pattern_;
+    std::vector<int> piece_offset_;
+    std::vector<int> piece_length_;
+    AhoCorasick filter_;
+
+    struct StopAtFirst {
+        bool found;
+        StopAtFirst() : found(false) {}
+        bool operator()(int) {
+            found = true;
+            return false;
+        }
+    };
+
+    // Piece hit: verify the window of text the pattern could occupy
+    template <class F>
+    struct Candidates {
+        const ApproxMatcher* self;
+        const char* text;
+        size_t len;
+        Scratch* scratch;
+        F* f;
+
+        bool operator()(int piece, size_t end) {
+            const int p = self->piece_pattern_[piece];
+            Scratch& sc = *scratch;
+            const bool seen = sc.stamp[p] == sc.current;
+            if (seen && sc.matched[p]) return true;
+
+            const size_t m = self->patterns_[p].size();
+            const size_t k = static_cast<size_t>(self->k_);
+            const size_t offset = static_cast<size_t>(self->piece_offset_[piece]);
+            const size_t piece_start = end - static_cast<size_t>(self->piece_length_[piece]);
+            const size_t w_start = piece_start > offset + k ? piece_start - offset - k : 0;
+            const size_t w_end = std::min(len, piece_start - offset + m + k);
+
+            // Occurrences inside a window already verified were ruled out
+            if (seen && w_start >= sc.from[p] && w_end <= sc.to[p]) return true;
+            sc.stamp[p] = sc.current;
+            sc.from[p] = w_start;
+            sc.to[p] = w_end;
+            sc.matched[p] = self->verify(p, text + w_start, w_end - w_start, sc);
+            return sc.matched[p] ? (*f)(p) : true;
+        }
+    };
+
+    void begin(Scratch& scratch) const {
+        const size_t n = patterns_.size();
+        if (scratch.stamp.size() != n || scratch.current == UINT32_MAX) {
+            scratch.stamp.assign(n, 0);
+            scratch.matched.assign(n, 0);
+            scratch.from.assign(n, 0);
+            scratch.to.assign(n, 0);
+            scratch.current = 0;
+        }
+        scratch.current++;
+    }
+
+    // True if pattern p occurs in text[0, len) within k edits
+    bool verify(int p, const char* text, size_t len, Scratch& scratch) const {
+        const std::string& pattern = patterns_[p];
+        const int m = static_cast<int>(pattern.size());
+        const uint8_t* s = reinterpret_cast<const uint8_t*>(text);
+        if (len + k_ < static_cast<size_t>(m)) return false;
+
+        if (peq_offset_[p] >= 0) {
+            // Myers: vertical deltas of the edit-distance column as bit vectors;
+            // the first row stays zero so matches may start anywhere
+            const uint64_t* peq = &peq_[peq_offset_[p]];
+            const uint64_t high = uint64_t(1) << (m - 1);
+            uint64_t pv = ~uint64_t(0), mv = 0;
+            int score = m;
+            for (size_t j = 0; j < len; j++) {
+                const uint64_t eq = peq[fold_[s[j]]];
+                const uint64_t xv = eq | mv;
+                const uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+                uint64_t ph = mv | ~(xh | pv);
+                uint64_t mh = pv & xh;
+                if (ph & high) score++;
+                else if (mh & high) score--;
+                if (score <= k_) return true;
+                ph <<= 1;
+                mh <<= 1;
+                pv = mh | ~(xv | ph);
+                mv = ph & xv;
+            }
+            return false;
+        }
+
+        // Ukkonen: only the prefix of the column with values <= k is kept,
+        // plus the row below it, which a deletion can bring down to k
+        std::vector<int>& c = scratch.column;
+        c.resize(static_cast<size_t>(m) + 1);
+        for (int i = 0; i <= m; i++) c[i] = i;
+        int last = std::min(k_ + 1, m);
+        for (size_t j = 0; j < len; j++) {
+            const uint8_t ch = fold_[s[j]];
+            int diag = 0, cur = 0;
+            for (int i = 1; i <= last; i++) {
+                int next;
+                if (static_cast<uint8_t>(pattern[i - 1]) == ch) {
+                    next = diag;
+                } else {
+                    next = std::min(std::min(diag, cur), c[i]) + 1;
+                }
+                diag = c[i];
+                c[i] = cur = next;
+            }
+            while (c[last] > k_) last--;
+            if (last == m) return true;
+            last++;
+        }
+        return false;
+    }
+};
+
+#endif
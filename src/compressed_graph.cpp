@@ -0,0 +1,153 @@
+#include <Rcpp.h>
+#include <vector>
+#include <chrono>
+#include <fstream>
+#include <cstring>
+#include <cstdint>
+#include "compressed_graph.h"
+#include "parallel_utils.h"
+
+static Rcpp::List compressed_graph_summary(const Rcpp::XPtr<CompressedGraph>& ptr) {
+    const CompressedGraph& g = *ptr;
+    const double n_arcs = g.n_input_edges - g.n_self_loops - g.n_invalid - g.n_duplicates;
+
+    return Rcpp::List::create(
+        Rcpp::Named("ptr") = ptr,
+        Rcpp::Named("n_nodes") = g.n_nodes,
+        Rcpp::Named("n_edges") = n_arcs,
+        Rcpp::Named("memory_bytes") = g.memory_bytes(),
+        Rcpp::Named("csr_bytes") = static_cast<double>(g.offsets.size() * sizeof(int64_t)) +
+                                   2.0 * n_arcs * sizeof(int),
+        Rcpp::Named("bits_per_edge") = n_arcs > 0 ? 8.0 * g.bytes.size() / (2.0 * n_arcs) : 0.0,
+        Rcpp::Named("build_seconds") = g.build_seconds
+    );
+}
+
+//' Build Compressed Graph
+//'
+//' Encodes the undirected graph as sorted, deduplicated, gap + varint coded
+//' adjacency lists. Self-loops and invalid rows are dropped.
+//'
+//' @param edges IntegerMatrix with two columns (from, to)
+//' @param n_nodes Number of nodes in the graph
+//' @param n_threads Number of threads; <= 0 uses all available
+//' @return List with the external pointer, edge count, memory use (and that of
+//'   an equivalent CSR), bits per edge and build time
+// [[Rcpp::export]]
+Rcpp::List compress_graph_cpp(const Rcpp::IntegerMatrix& edges, int n_nodes, int n_threads = 0) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    const int* from = edges.begin();
+    const int* to = from + edges.nrow();
+
+    CompressedGraph* g = new CompressedGraph();
+    Rcpp::XPtr<CompressedGraph> ptr(g, true);
+    build_compressed_graph(from, to, edges.nrow(), n_nodes, resolve_threads(n_threads), *g);
+
+    g->build_seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+
+    return compressed_graph_summary(ptr);
+}
+
+//' Decode Compressed Adjacency Lists
+//'
+//' @param graph_ptr External pointer returned by compress_graph_cpp
+//' @param nodes Node IDs (1-based)
+//' @return List of integer vectors of neighbor IDs (1-based, increasing)
+// [[Rcpp::export]]
+Rcpp::List compressed_neighbors_cpp(SEXP graph_ptr, const Rcpp::IntegerVector& nodes) {
+    const CompressedGraph* g = get_compressed_graph(graph_ptr);
+
+    Rcpp::List result(nodes.size());
+    for (R_xlen_t i = 0; i < nodes.size(); i++) {
+        if (nodes[i] == NA_INTEGER || nodes[i] < 1 || nodes[i] > g->n_nodes) {
+            result[i] = Rcpp::IntegerVector(0);
+            continue;
+        }
+        int u = nodes[i] - 1;
+        Rcpp::IntegerVector adj(g->degree(u));
+        CompressedGraph::Cursor cursor = g->neighbors(u);
+        int v, k = 0;
+        while (cursor.next(v)) adj[k++] = v + 1;
+        result[i] = adj;
+    }
+
+    return result;
+}
+
+static const char COMPRESSED_GRAPH_MAGIC[8] = {'G', 'F', 'C', 'G', 'v', '1', '\0', '\0'};
+
+//' Save Compressed Graph
+//'
+//' @param graph_ptr External pointer returned by compress_graph_cpp
+//' @param path Output file path
+// [[Rcpp::export]]
+void save_compressed_graph_cpp(SEXP graph_ptr, std::string path) {
+    const CompressedGraph* g = get_compressed_graph(graph_ptr);
+
+    std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+    if (!out) {
+        Rcpp::stop("Cannot open '%s' for writing", path);
+    }
+
+    int64_t n_bytes = static_cast<int64_t>(g->bytes.size());
+    double counts[5] = {g->n_input_edges, g->n_self_loops, g->n_invalid, g->n_duplicates, g->build_seconds};
+    out.write(COMPRESSED_GRAPH_MAGIC, sizeof(COMPRESSED_GRAPH_MAGIC));
+    out.write(reinterpret_cast<const char*>(&g->n_nodes), sizeof(int));
+    out.write(reinterpret_cast<const char*>(&n_bytes), sizeof(int64_t));
+    out.write(reinterpret_cast<const char*>(counts), sizeof(counts));
+    out.write(reinterpret_cast<const char*>(g->offsets.data()), g->offsets.size() * sizeof(int64_t));
+    out.write(reinterpret_cast<const char*>(g->bytes.data()), n_bytes);
+
+    if (!out) {
+        Rcpp::stop("Failed writing compressed graph to '%s'", path);
+    }
+}
+
+//' Load Compressed Graph
+//'
+//' @param path File written by save_compressed_graph_cpp
+//' @return Same list structure as compress_graph_cpp
+// [[Rcpp::export]]
+Rcpp::List load_compressed_graph_cpp(std::string path) {
+    std::ifstream in(path.c_str(), std::ios::binary);
+    if (!in) {
+        Rcpp::stop("Cannot open '%s' for reading", path);
+    }
+
+    char magic[sizeof(COMPRESSED_GRAPH_MAGIC)];
+    in.read(magic, sizeof(magic));
+    if (!in || std::memcmp(magic, COMPRESSED_GRAPH_MAGIC, sizeof(magic)) != 0) {
+        Rcpp::stop("'%s' is not a graphfast compressed graph", path);
+    }
+
+    CompressedGraph* g = new CompressedGraph();
+    Rcpp::XPtr<CompressedGraph> ptr(g, true);
+
+    int64_t n_bytes = 0;
+    double counts[5];
+    in.read(reinterpret_cast<char*>(&g->n_nodes), sizeof(int));
+    in.read(reinterpret_cast<char*>(&n_bytes), sizeof(int64_t));
+    in.read(reinterpret_cast<char*>(counts), sizeof(counts));
+    if (!in || g->n_nodes < 0 || n_bytes < 0) {
+        Rcpp::stop("Corrupt compressed graph header in '%s'", path);
+    }
+    g->n_input_edges = counts[0];
+    g->n_self_loops = counts[1];
+    g->n_invalid = counts[2];
+    g->n_duplicates = counts[3];
+    g->build_seconds = counts[4];
+
+    g->offsets.resize(static_cast<size_t>(g->n_nodes) + 1);
+    g->bytes.resize(static_cast<size_t>(n_bytes));
+    in.read(reinterpret_cast<char*>(g->offsets.data()), g->offsets.size() * sizeof(int64_t));
+    in.read(reinterpret_cast<char*>(g->bytes.data()), n_bytes);
+
+    // Queries decode lists without bounds checks, so vet them all here
+    if (!in || !g->valid()) {
+        Rcpp::stop("Truncated or corrupt compressed graph in '%s'", path);
+    }
+
+    return compressed_graph_summary(ptr);
+}
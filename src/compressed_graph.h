@@ -0,0 +1,310 @@
+#ifndef GRAPHFAST_COMPRESSED_GRAPH_H
+#define GRAPHFAST_COMPRESSED_GRAPH_H
+
+#include <Rcpp.h>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include "parallel_utils.h"
+
+// Gap-encoded adjacency in the style of WebGraph (Boldi & Vigna, 2004).
+//
+// Each node's neighbors are sorted, deduplicated and written as LEB128
+// varints: the degree, the first neighbor as a zigzag offset from the node
+// itself, then the gaps between consecutive neighbors minus one. Locally
+// numbered graphs (see reorder_graph) need one or two bytes per neighbor
+// instead of the four a CSR uses.
+struct CompressedGraph {
+    int n_nodes;
+    std::vector<int64_t> offsets;  // byte offset of each node's list, n_nodes + 1
+    std::vector<uint8_t> bytes;
+
+    // Edge-quality counts recorded while building
+    double n_input_edges;
+    double n_self_loops;
+    double n_invalid;
+    double n_duplicates;
+    double build_seconds;
+
+    CompressedGraph()
+        : n_nodes(0), offsets(1, 0), n_input_edges(0), n_self_loops(0), n_invalid(0),
+          n_duplicates(0), build_seconds(0) {}
+
+    static inline uint64_t read_varint(const uint8_t*& p) {
+        uint64_t value = *p & 0x7F;
+        int shift = 7;
+        while (*p++ & 0x80) {
+            value |= static_cast<uint64_t>(*p & 0x7F) << shift;
+            shift += 7;
+        }
+        return value;
+    }
+
+    // Bounded read_varint: false if the varint does not end before `end` or
+    // does not fit in 64 bits
+    static inline bool read_varint_checked(const uint8_t*& p, const uint8_t* end, uint64_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (p == end) return false;
+            const uint8_t b = *p++;
+            value |= static_cast<uint64_t>(b & 0x7F) << shift;
+            if (!(b & 0x80)) return true;
+        }
+        return false;
+    }
+
+    // Forward-only cursor over one adjacency list, in increasing order
+    struct Cursor {
+        const uint8_t* p;
+        int remaining;
+        int current;
+        bool at_first;
+
+        bool next(int& v) {
+            if (remaining == 0) return false;
+            remaining--;
+            if (at_first) {
+                at_first = false;
+            } else {
+                current += static_cast<int>(read_varint(p)) + 1;
+            }
+            v = current;
+            return true;
+        }
+    };
+
+    Cursor neighbors(int u) const {
+        Cursor c;
+        c.p = bytes.data() + offsets[u];
+        c.remaining = static_cast<int>(read_varint(c.p));
+        c.current = 0;
+        c.at_first = c.remaining > 0;
+        if (c.at_first) {
+            uint64_t zz = read_varint(c.p);
+            int64_t delta = static_cast<int64_t>(zz >> 1) ^ -static_cast<int64_t>(zz & 1);
+            c.current = static_cast<int>(u + delta);
+        }
+        return c;
+    }
+
+    int degree(int u) const {
+        const uint8_t* p = bytes.data() + offsets[u];
+        return static_cast<int>(read_varint(p));
+    }
+
+    // Decodes every list once and checks it against the file layout: offsets
+    // run from 0 to bytes.size() without decreasing, each list's varints end
+    // inside its own byte range and account for all of it, and every neighbor
+    // lies in [0, n_nodes). The readers above trust all of this.
+    bool valid() const {
+        if (n_nodes < 0 || offsets.size() != static_cast<size_t>(n_nodes) + 1 || offsets[0] != 0 ||
+            offsets[n_nodes] != static_cast<int64_t>(bytes.size())) {
+            return false;
+        }
+        for (int u = 0; u < n_nodes; u++) {
+            if (offsets[u] > offsets[u + 1]) return false;
+        }
+
+        for (int u = 0; u < n_nodes; u++) {
+            const uint8_t* p = bytes.data() + offsets[u];
+            const uint8_t* end = bytes.data() + offsets[u + 1];
+            uint64_t degree;
+            if (!read_varint_checked(p, end, degree)) return false;
+            if (degree > 0) {
+                uint64_t zz;
+                if (!read_varint_checked(p, end, zz)) return false;
+                const int64_t delta = static_cast<int64_t>(zz >> 1) ^ -static_cast<int64_t>(zz & 1);
+                if (delta < -static_cast<int64_t>(u) || delta >= static_cast<int64_t>(n_nodes) - u) {
+                    return false;
+                }
+                int64_t v = u + delta;
+                for (uint64_t k = 1; k < degree; k++) {
+                    uint64_t gap;
+                    if (!read_varint_checked(p, end, gap) || gap >= static_cast<uint64_t>(n_nodes - 1 - v)) {
+                        return false;
+                    }
+                    v += static_cast<int64_t>(gap) + 1;
+                }
+            }
+            if (p != end) return false;
+        }
+        return true;
+    }
+
+    double memory_bytes() const {
+        return static_cast<double>(offsets.size() * sizeof(int64_t) + bytes.size());
+    }
+};
+
+inline int varint_size(uint64_t value) {
+    int size = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        size++;
+    }
+    return size;
+}
+
+inline uint8_t* write_varint(uint8_t* p, uint64_t value) {
+    while (value >= 0x80) {
+        *p++ = static_cast<uint8_t>(value | 0x80);
+        value >>= 7;
+    }
+    *p++ = static_cast<uint8_t>(value);
+    return p;
+}
+
+inline uint64_t zigzag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+// Encoded size of a sorted, duplicate-free list for node u
+inline int64_t encoded_list_size(int u, const int* list, int len) {
+    int64_t size = varint_size(static_cast<uint64_t>(len));
+    if (len > 0) {
+        size += varint_size(zigzag(static_cast<int64_t>(list[0]) - u));
+        for (int i = 1; i < len; i++) {
+            size += varint_size(static_cast<uint64_t>(list[i] - list[i - 1] - 1));
+        }
+    }
+    return size;
+}
+
+inline void encode_list(int u, const int* list, int len, uint8_t* p) {
+    p = write_varint(p, static_cast<uint64_t>(len));
+    if (len > 0) {
+        p = write_varint(p, zigzag(static_cast<int64_t>(list[0]) - u));
+        for (int i = 1; i < len; i++) {
+            p = write_varint(p, static_cast<uint64_t>(list[i] - list[i - 1] - 1));
+        }
+    }
+}
+
+// Builds the compressed graph straight from the columns of an R edge matrix
+// (1-based IDs) without materialising a full CSR: nodes are processed in
+// ranges whose adjacency fits a bounded buffer (1/16 of a CSR, at least 64M
+// entries), with one parallel scan of the edges per range.
+inline void build_compressed_graph(const int* from, const int* to, int64_t n_edges, int n_nodes,
+                                   int n_threads, CompressedGraph& g) {
+    g.n_nodes = n_nodes;
+    g.n_input_edges = static_cast<double>(n_edges);
+    g.offsets.assign(static_cast<size_t>(n_nodes) + 1, 0);
+    g.bytes.clear();
+
+    std::vector<int> degree(n_nodes, 0);
+    int64_t n_self_loops = 0, n_invalid = 0;
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(n_threads) schedule(static) reduction(+:n_self_loops,n_invalid)
+#endif
+    for (int64_t i = 0; i < n_edges; i++) {
+        if (from[i] == NA_INTEGER || to[i] == NA_INTEGER) {
+            n_invalid++;
+            continue;
+        }
+        int u = from[i] - 1;
+        int v = to[i] - 1;
+        if (u < 0 || u >= n_nodes || v < 0 || v >= n_nodes) {
+            n_invalid++;
+            continue;
+        }
+        if (u == v) {
+            n_self_loops++;
+            continue;
+        }
+        __atomic_fetch_add(&degree[u], 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&degree[v], 1, __ATOMIC_RELAXED);
+    }
+
+    int64_t total_entries = 0;
+    for (int u = 0; u < n_nodes; u++) total_entries += degree[u];
+    const int64_t budget = std::max<int64_t>(int64_t(1) << 26, total_entries / 16);
+
+    std::vector<int64_t> local_offsets;
+    std::vector<int64_t> cursor;
+    std::vector<int> buffer;
+    std::vector<int> length;
+    int64_t simple_entries = 0;
+
+    for (int start = 0; start < n_nodes;) {
+        int end = start;
+        int64_t chunk_entries = 0;
+        while (end < n_nodes && (end == start || chunk_entries + degree[end] <= budget)) {
+            chunk_entries += degree[end++];
+        }
+        const int n_chunk = end - start;
+
+        local_offsets.assign(static_cast<size_t>(n_chunk) + 1, 0);
+        for (int k = 0; k < n_chunk; k++) {
+            local_offsets[k + 1] = local_offsets[k] + degree[start + k];
+        }
+        cursor.assign(local_offsets.begin(), local_offsets.end() - 1);
+        buffer.resize(static_cast<size_t>(chunk_entries));
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(n_threads) schedule(static)
+#endif
+        for (int64_t i = 0; i < n_edges; i++) {
+            if (from[i] == NA_INTEGER || to[i] == NA_INTEGER) continue;
+            int u = from[i] - 1;
+            int v = to[i] - 1;
+            if (u < 0 || u >= n_nodes || v < 0 || v >= n_nodes || u == v) continue;
+            if (u >= start && u < end) {
+                buffer[__atomic_fetch_add(&cursor[u - start], 1, __ATOMIC_RELAXED)] = v;
+            }
+            if (v >= start && v < end) {
+                buffer[__atomic_fetch_add(&cursor[v - start], 1, __ATOMIC_RELAXED)] = u;
+            }
+        }
+
+        // Sort and dedupe each list, then size it so lists can be encoded in place
+        length.assign(n_chunk, 0);
+        int64_t chunk_simple = 0;
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(n_threads) schedule(dynamic, 256) reduction(+:chunk_simple)
+#endif
+        for (int k = 0; k < n_chunk; k++) {
+            int* list = buffer.data() + local_offsets[k];
+            int* list_end = buffer.data() + local_offsets[k + 1];
+            std::sort(list, list_end);
+            length[k] = static_cast<int>(std::unique(list, list_end) - list);
+            chunk_simple += length[k];
+            cursor[k] = encoded_list_size(start + k, list, length[k]);
+        }
+        simple_entries += chunk_simple;
+
+        for (int k = 0; k < n_chunk; k++) {
+            g.offsets[start + k + 1] = g.offsets[start + k] + cursor[k];
+        }
+        g.bytes.resize(static_cast<size_t>(g.offsets[end]));
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(n_threads) schedule(dynamic, 256)
+#endif
+        for (int k = 0; k < n_chunk; k++) {
+            encode_list(start + k, buffer.data() + local_offsets[k], length[k],
+                        g.bytes.data() + g.offsets[start + k]);
+        }
+
+        start = end;
+        Rcpp::checkUserInterrupt();
+    }
+
+    const int64_t n_valid = n_edges - n_invalid - n_self_loops;
+    g.n_self_loops = static_cast<double>(n_self_loops);
+    g.n_invalid = static_cast<double>(n_invalid);
+    g.n_duplicates = static_cast<double>(n_valid - simple_entries / 2);
+    g.bytes.shrink_to_fit();
+}
+
+inline CompressedGraph* get_compressed_graph(SEXP ptr) {
+    Rcpp::XPtr<CompressedGraph> xp(ptr);
+    if (xp.get() == nullptr) {
+        Rcpp::stop("Compressed graph is no longer valid (external pointers do not survive "
+                   "saveRDS or a new session). Use save_compressed_graph()/load_compressed_graph().");
+    }
+    return xp.get();
+}
+
+#endif
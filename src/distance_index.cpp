@@ -0,0 +1,299 @@
+#include <Rcpp.h>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <cstring>
+#include <cstdint>
+#include <limits>
+#include "graph_csr.h"
+
+// Exact 2-hop distance labels built by pruned landmark labeling
+// (Akiba, Iwata & Yoshida, 2013). Hubs are identified by their rank in the
+// degree ordering, and each node's label is sorted by hub rank so a query is
+// a single merge of two short arrays.
+struct PrunedLandmarkIndex {
+    int n_nodes;
+    std::vector<int64_t> offsets;  // n_nodes + 1
+    std::vector<int> hubs;
+    std::vector<int> dists;
+    double build_seconds;
+
+    PrunedLandmarkIndex() : n_nodes(0), offsets(1, 0), build_seconds(0.0) {}
+
+    double memory_bytes() const {
+        return static_cast<double>(offsets.size() * sizeof(int64_t) +
+                                   hubs.size() * sizeof(int) +
+                                   dists.size() * sizeof(int));
+    }
+
+    // Distance between u and v (0-based), -1 if disconnected
+    int query(int u, int v) const {
+        if (u == v) return 0;
+
+        int64_t i = offsets[u], i_end = offsets[u + 1];
+        int64_t j = offsets[v], j_end = offsets[v + 1];
+        int best = std::numeric_limits<int>::max();
+
+        while (i < i_end && j < j_end) {
+            int hu = hubs[i];
+            int hv = hubs[j];
+            if (hu == hv) {
+                int d = dists[i] + dists[j];
+                if (d < best) best = d;
+                i++;
+                j++;
+            } else if (hu < hv) {
+                i++;
+            } else {
+                j++;
+            }
+        }
+
+        return best == std::numeric_limits<int>::max() ? -1 : best;
+    }
+};
+
+static void build_pruned_labels(const CSRGraph& g, PrunedLandmarkIndex& index) {
+    const int n = g.n_nodes;
+    const int unset = std::numeric_limits<int>::max();
+
+    // High-degree nodes first: they cover the most shortest paths and let
+    // later BFS runs prune early.
+    std::vector<int> order(n);
+    for (int i = 0; i < n; i++) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&g](int a, int b) {
+        return g.degree(a) > g.degree(b);
+    });
+
+    std::vector<std::vector<std::pair<int, int>>> labels(n);
+    std::vector<int> root_label(n, unset);  // indexed by hub rank
+    std::vector<int> distance(n, -1);
+    std::vector<int> queue(n);
+
+    for (int k = 0; k < n; k++) {
+        int root = order[k];
+
+        for (const auto& entry : labels[root]) {
+            root_label[entry.first] = entry.second;
+        }
+
+        int head = 0, tail = 0;
+        queue[tail++] = root;
+        distance[root] = 0;
+
+        while (head < tail) {
+            int u = queue[head++];
+            int du = distance[u];
+
+            // Prune if the labels built so far already certify a path
+            // from root to u that is no longer than du
+            bool pruned = false;
+            for (const auto& entry : labels[u]) {
+                int via = root_label[entry.first];
+                if (via != unset && via + entry.second <= du) {
+                    pruned = true;
+                    break;
+                }
+            }
+            if (pruned) continue;
+
+            labels[u].emplace_back(k, du);
+
+            for (int64_t e = g.begin(u); e < g.end(u); e++) {
+                int v = g.targets[e];
+                if (distance[v] == -1) {
+                    distance[v] = du + 1;
+                    queue[tail++] = v;
+                }
+            }
+        }
+
+        for (int i = 0; i < tail; i++) {
+            distance[queue[i]] = -1;
+        }
+        for (const auto& entry : labels[root]) {
+            root_label[entry.first] = unset;
+        }
+
+        if ((k & 1023) == 0) {
+            Rcpp::checkUserInterrupt();
+        }
+    }
+
+    // Flatten into contiguous arrays
+    index.n_nodes = n;
+    index.offsets.assign(static_cast<size_t>(n) + 1, 0);
+    for (int i = 0; i < n; i++) {
+        index.offsets[i + 1] = index.offsets[i] + static_cast<int64_t>(labels[i].size());
+    }
+    index.hubs.resize(static_cast<size_t>(index.offsets[n]));
+    index.dists.resize(index.hubs.size());
+    for (int i = 0; i < n; i++) {
+        int64_t pos = index.offsets[i];
+        for (const auto& entry : labels[i]) {
+            index.hubs[pos] = entry.first;
+            index.dists[pos] = entry.second;
+            pos++;
+        }
+        std::vector<std::pair<int, int>>().swap(labels[i]);
+    }
+}
+
+static Rcpp::List distance_index_summary(const Rcpp::XPtr<PrunedLandmarkIndex>& ptr) {
+    const PrunedLandmarkIndex& index = *ptr;
+    double n_entries = static_cast<double>(index.hubs.size());
+
+    return Rcpp::List::create(
+        Rcpp::Named("ptr") = ptr,
+        Rcpp::Named("n_nodes") = index.n_nodes,
+        Rcpp::Named("n_label_entries") = n_entries,
+        Rcpp::Named("avg_label_size") = index.n_nodes > 0 ? n_entries / index.n_nodes : 0.0,
+        Rcpp::Named("memory_bytes") = index.memory_bytes(),
+        Rcpp::Named("build_seconds") = index.build_seconds
+    );
+}
+
+static PrunedLandmarkIndex* get_distance_index(SEXP ptr) {
+    Rcpp::XPtr<PrunedLandmarkIndex> xp(ptr);
+    if (xp.get() == nullptr) {
+        Rcpp::stop("Distance index is no longer valid (external pointers do not survive "
+                   "saveRDS or a new session). Use save_distance_index()/load_distance_index().");
+    }
+    return xp.get();
+}
+
+//' Build Pruned Landmark Labeling Distance Index
+//'
+//' Precomputes exact 2-hop distance labels for an unweighted, undirected
+//' graph so that later distance queries are a merge of two sorted labels
+//' instead of a BFS.
+//'
+//' @param edges IntegerMatrix with two columns (from, to)
+//' @param n_nodes Number of nodes in the graph
+//' @return List with the external pointer, label statistics, memory use and build time
+// [[Rcpp::export]]
+Rcpp::List build_distance_index_cpp(const Rcpp::IntegerMatrix& edges, int n_nodes) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    const int* from = edges.begin();
+    const int* to = from + edges.nrow();
+    CSRGraph g = build_csr(from, to, edges.nrow(), n_nodes);
+
+    PrunedLandmarkIndex* index = new PrunedLandmarkIndex();
+    Rcpp::XPtr<PrunedLandmarkIndex> ptr(index, true);
+    build_pruned_labels(g, *index);
+
+    index->build_seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+
+    return distance_index_summary(ptr);
+}
+
+//' Query Distance Index
+//'
+//' @param index_ptr External pointer returned by build_distance_index_cpp
+//' @param query_pairs IntegerMatrix of (source, target) pairs
+//' @param max_distance Maximum distance; larger distances return -1. <= 0 means no limit.
+//' @return Integer vector of distances, -1 if no path
+// [[Rcpp::export]]
+Rcpp::IntegerVector query_distance_index_cpp(SEXP index_ptr, const Rcpp::IntegerMatrix& query_pairs,
+                                             int max_distance = -1) {
+    const PrunedLandmarkIndex* index = get_distance_index(index_ptr);
+    const int n_nodes = index->n_nodes;
+
+    Rcpp::IntegerVector result(query_pairs.nrow());
+    for (int q = 0; q < query_pairs.nrow(); q++) {
+        int u = query_pairs(q, 0) - 1;
+        int v = query_pairs(q, 1) - 1;
+
+        if (u < 0 || u >= n_nodes || v < 0 || v >= n_nodes) {
+            result[q] = -1;
+            continue;
+        }
+
+        int d = index->query(u, v);
+        result[q] = (max_distance > 0 && d > max_distance) ? -1 : d;
+    }
+
+    return result;
+}
+
+static const char DISTANCE_INDEX_MAGIC[8] = {'G', 'F', 'P', 'L', 'L', 'v', '1', '\0'};
+
+//' Save Distance Index
+//'
+//' @param index_ptr External pointer returned by build_distance_index_cpp
+//' @param path Output file path
+// [[Rcpp::export]]
+void save_distance_index_cpp(SEXP index_ptr, std::string path) {
+    const PrunedLandmarkIndex* index = get_distance_index(index_ptr);
+
+    std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+    if (!out) {
+        Rcpp::stop("Cannot open '%s' for writing", path);
+    }
+
+    int64_t n_entries = static_cast<int64_t>(index->hubs.size());
+    out.write(DISTANCE_INDEX_MAGIC, sizeof(DISTANCE_INDEX_MAGIC));
+    out.write(reinterpret_cast<const char*>(&index->n_nodes), sizeof(int));
+    out.write(reinterpret_cast<const char*>(&n_entries), sizeof(int64_t));
+    out.write(reinterpret_cast<const char*>(&index->build_seconds), sizeof(double));
+    out.write(reinterpret_cast<const char*>(index->offsets.data()),
+              index->offsets.size() * sizeof(int64_t));
+    out.write(reinterpret_cast<const char*>(index->hubs.data()), n_entries * sizeof(int));
+    out.write(reinterpret_cast<const char*>(index->dists.data()), n_entries * sizeof(int));
+
+    if (!out) {
+        Rcpp::stop("Failed writing distance index to '%s'", path);
+    }
+}
+
+//' Load Distance Index
+//'
+//' @param path File written by save_distance_index_cpp
+//' @return Same list structure as build_distance_index_cpp
+// [[Rcpp::export]]
+Rcpp::List load_distance_index_cpp(std::string path) {
+    std::ifstream in(path.c_str(), std::ios::binary);
+    if (!in) {
+        Rcpp::stop("Cannot open '%s' for reading", path);
+    }
+
+    char magic[sizeof(DISTANCE_INDEX_MAGIC)];
+    in.read(magic, sizeof(magic));
+    if (!in || std::memcmp(magic, DISTANCE_INDEX_MAGIC, sizeof(magic)) != 0) {
+        Rcpp::stop("'%s' is not a graphfast distance index", path);
+    }
+
+    PrunedLandmarkIndex* index = new PrunedLandmarkIndex();
+    Rcpp::XPtr<PrunedLandmarkIndex> ptr(index, true);
+
+    int64_t n_entries = 0;
+    in.read(reinterpret_cast<char*>(&index->n_nodes), sizeof(int));
+    in.read(reinterpret_cast<char*>(&n_entries), sizeof(int64_t));
+    in.read(reinterpret_cast<char*>(&index->build_seconds), sizeof(double));
+    if (!in || index->n_nodes < 0 || n_entries < 0) {
+        Rcpp::stop("Corrupt distance index header in '%s'", path);
+    }
+
+    index->offsets.resize(static_cast<size_t>(index->n_nodes) + 1);
+    index->hubs.resize(static_cast<size_t>(n_entries));
+    index->dists.resize(static_cast<size_t>(n_entries));
+    in.read(reinterpret_cast<char*>(index->offsets.data()), index->offsets.size() * sizeof(int64_t));
+    in.read(reinterpret_cast<char*>(index->hubs.data()), n_entries * sizeof(int));
+    in.read(reinterpret_cast<char*>(index->dists.data()), n_entries * sizeof(int));
+
+    // Label ranges must run from 0 to n_entries without going backwards,
+    // or queries would read outside hubs and dists
+    bool valid = static_cast<bool>(in) && index->offsets[0] == 0 &&
+                 index->offsets[index->n_nodes] == n_entries;
+    for (int v = 0; valid && v < index->n_nodes; v++) {
+        valid = index->offsets[v] <= index->offsets[v + 1];
+    }
+    if (!valid) {
+        Rcpp::stop("Truncated or corrupt distance index in '%s'", path);
+    }
+
+    return distance_index_summary(ptr);
+}
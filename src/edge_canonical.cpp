@@ -0,0 +1,44 @@
+#include <Rcpp.h>
+#include <vector>
+#include <cstdint>
+#include "edge_canonical.h"
+#include "parallel_utils.h"
+
+//' Canonicalize Edge List
+//'
+//' Orders every pair so that from < to, radix-sorts the pairs in parallel,
+//' collapses duplicates and drops self-loops and invalid rows. The result is
+//' a simple undirected edge list sorted by (from, to).
+//'
+//' @param edges IntegerMatrix with two columns (from, to)
+//' @param n_nodes Number of nodes in the graph; larger IDs count as invalid
+//' @param keep_counts Whether to return the multiplicity of each edge
+//' @param n_threads Number of threads; <= 0 uses all available
+//' @return List with from, to (1-based), count (if requested) and the number
+//'   of self-loops, invalid rows and duplicates removed
+// [[Rcpp::export]]
+Rcpp::List canonicalize_edges_cpp(const Rcpp::IntegerMatrix& edges, int n_nodes,
+                                  bool keep_counts = false, int n_threads = 0) {
+    const int* from = edges.begin();
+    const int* to = from + edges.nrow();
+
+    CanonicalEdges out;
+    canonicalize_edge_list(from, to, edges.nrow(), n_nodes, keep_counts,
+                           resolve_threads(n_threads), out);
+
+    const R_xlen_t n = static_cast<R_xlen_t>(out.from.size());
+    Rcpp::IntegerVector res_from(n), res_to(n);
+    for (R_xlen_t i = 0; i < n; i++) {
+        res_from[i] = out.from[i] + 1;
+        res_to[i] = out.to[i] + 1;
+    }
+
+    return Rcpp::List::create(
+        Rcpp::Named("from") = res_from,
+        Rcpp::Named("to") = res_to,
+        Rcpp::Named("count") = Rcpp::IntegerVector(out.count.begin(), out.count.end()),
+        Rcpp::Named("n_self_loops") = static_cast<double>(out.n_self_loops),
+        Rcpp::Named("n_invalid") = static_cast<double>(out.n_invalid),
+        Rcpp::Named("n_duplicates") = static_cast<double>(out.n_duplicates)
+    );
+}
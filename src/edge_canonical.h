@@ -0,0 +1,162 @@
+#ifndef GRAPHFAST_EDGE_CANONICAL_H
+#define GRAPHFAST_EDGE_CANONICAL_H
+
+#include <Rcpp.h>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include "parallel_utils.h"
+
+// Parallel LSD radix sort of 64-bit keys on their low `key_bits` bits.
+//
+// The array is split into one contiguous chunk per thread. Each pass builds
+// per-chunk digit histograms, turns them into (digit, thread) scatter
+// offsets and scatters stably, so the result is identical for any thread
+// count. Passes where every key has the same digit are skipped.
+inline void radix_sort_keys(std::vector<uint64_t>& keys, int key_bits, int n_threads) {
+    const int RADIX_BITS = 8;
+    const int RADIX = 1 << RADIX_BITS;
+    const int64_t n = static_cast<int64_t>(keys.size());
+    if (n < 2) return;
+
+    if (n < 4096) {
+        n_threads = 1;
+    }
+
+    std::vector<uint64_t> buffer(keys.size());
+    std::vector<int64_t> counts(static_cast<size_t>(n_threads) * RADIX);
+
+    for (int shift = 0; shift < key_bits; shift += RADIX_BITS) {
+        std::fill(counts.begin(), counts.end(), 0);
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(n_threads) schedule(static, 1)
+#endif
+        for (int t = 0; t < n_threads; t++) {
+            const int64_t lo = n * t / n_threads;
+            const int64_t hi = n * (t + 1) / n_threads;
+            int64_t* local = &counts[static_cast<size_t>(t) * RADIX];
+            for (int64_t i = lo; i < hi; i++) {
+                local[(keys[i] >> shift) & (RADIX - 1)]++;
+            }
+        }
+
+        // Exclusive prefix over (digit, chunk) in digit-major order
+        bool skip = false;
+        int64_t total = 0;
+        for (int d = 0; d < RADIX; d++) {
+            for (int t = 0; t < n_threads; t++) {
+                int64_t c = counts[static_cast<size_t>(t) * RADIX + d];
+                if (c == n) skip = true;
+                counts[static_cast<size_t>(t) * RADIX + d] = total;
+                total += c;
+            }
+        }
+        if (skip) continue;
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(n_threads) schedule(static, 1)
+#endif
+        for (int t = 0; t < n_threads; t++) {
+            const int64_t lo = n * t / n_threads;
+            const int64_t hi = n * (t + 1) / n_threads;
+            int64_t* local = &counts[static_cast<size_t>(t) * RADIX];
+            for (int64_t i = lo; i < hi; i++) {
+                uint64_t key = keys[i];
+                buffer[local[(key >> shift) & (RADIX - 1)]++] = key;
+            }
+        }
+
+        keys.swap(buffer);
+    }
+}
+
+// Number of bits needed to represent values 0 .. n - 1
+inline int bits_for(int64_t n) {
+    int bits = 0;
+    while (bits < 62 && (int64_t(1) << bits) < n) bits++;
+    return bits;
+}
+
+struct CanonicalEdges {
+    std::vector<int> from;   // 0-based, from[i] < to[i]
+    std::vector<int> to;
+    std::vector<int> count;  // multiplicity of each edge, empty unless requested
+    int64_t n_self_loops;
+    int64_t n_invalid;
+    int64_t n_duplicates;
+
+    CanonicalEdges() : n_self_loops(0), n_invalid(0), n_duplicates(0) {}
+};
+
+// Canonical simple-graph edge list: every pair ordered so u < v, sorted by
+// (u, v), duplicates collapsed and self-loops / invalid rows dropped.
+// from/to point at the two columns of an R edge matrix (1-based IDs).
+inline void canonicalize_edge_list(const int* from, const int* to, int64_t n_edges, int n_nodes,
+                                   bool keep_counts, int n_threads, CanonicalEdges& out) {
+    const int bits = bits_for(n_nodes);
+    std::vector<uint64_t> keys(static_cast<size_t>(n_edges));
+    std::vector<int64_t> keep(n_threads + 1, 0);
+    int64_t n_self_loops = 0, n_invalid = 0;
+
+    // Pack (min, max) into one key and compact the valid rows, each thread
+    // writing its share to the front of its own chunk
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(n_threads) schedule(static, 1) reduction(+:n_self_loops,n_invalid)
+#endif
+    for (int t = 0; t < n_threads; t++) {
+        const int64_t lo = n_edges * t / n_threads;
+        const int64_t hi = n_edges * (t + 1) / n_threads;
+        int64_t pos = lo;
+
+        for (int64_t i = lo; i < hi; i++) {
+            if (from[i] == NA_INTEGER || to[i] == NA_INTEGER) {
+                n_invalid++;
+                continue;
+            }
+            int u = from[i] - 1;
+            int v = to[i] - 1;
+            if (u < 0 || u >= n_nodes || v < 0 || v >= n_nodes) {
+                n_invalid++;
+                continue;
+            }
+            if (u == v) {
+                n_self_loops++;
+                continue;
+            }
+            if (u > v) std::swap(u, v);
+            keys[pos++] = (static_cast<uint64_t>(u) << bits) | static_cast<uint64_t>(v);
+        }
+        keep[t + 1] = pos - lo;
+    }
+
+    int64_t n_valid = 0;
+    for (int t = 0; t < n_threads; t++) {
+        int64_t lo = n_edges * t / n_threads;
+        std::copy(keys.begin() + lo, keys.begin() + lo + keep[t + 1], keys.begin() + n_valid);
+        n_valid += keep[t + 1];
+    }
+    keys.resize(static_cast<size_t>(n_valid));
+
+    radix_sort_keys(keys, 2 * bits, n_threads);
+
+    const uint64_t mask = (uint64_t(1) << bits) - 1;
+    out.from.clear();
+    out.to.clear();
+    out.count.clear();
+    for (int64_t i = 0; i < n_valid; i++) {
+        if (i > 0 && keys[i] == keys[i - 1]) {
+            if (keep_counts) out.count.back()++;
+            continue;
+        }
+        out.from.push_back(static_cast<int>(keys[i] >> bits));
+        out.to.push_back(static_cast<int>(keys[i] & mask));
+        if (keep_counts) out.count.push_back(1);
+    }
+
+    out.n_self_loops = n_self_loops;
+    out.n_invalid = n_invalid;
+    out.n_duplicates = n_valid - static_cast<int64_t>(out.from.size());
+}
+
+#endif
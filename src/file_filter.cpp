@@ -0,0 +1,178 @@
+#include <Rcpp.h>
+#include <vector>
+#include <memory>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <climits>
+#include <algorithm>
+#include "pattern_matcher.h"
+#include "mapped_file.h"
+#include "parallel_utils.h"
+
+// Lines of one chunk that were selected: their indices within the chunk,
+// or, when writing, their byte ranges (adjacent lines merged into one range)
+struct ChunkLines {
+    int64_t n_lines;
+    int64_t n_selected;
+    std::vector<int64_t> selected;
+    std::vector<std::pair<size_t, size_t>> ranges;
+};
+
+// Chunk boundaries: roughly equal byte ranges, each moved forward to just
+// past a newline so that no line is split between chunks
+static std::vector<size_t> line_aligned_chunks(const char* data, size_t size, size_t chunk_bytes) {
+    std::vector<size_t> bounds(1, 0);
+    size_t pos = 0;
+    while (size - pos > chunk_bytes) {
+        const char* nl = static_cast<const char*>(std::memchr(data + pos + chunk_bytes, '\n',
+                                                              size - pos - chunk_bytes));
+        if (nl == NULL) break;
+        pos = static_cast<size_t>(nl - data) + 1;
+        if (pos < size) bounds.push_back(pos);
+    }
+    bounds.push_back(size);
+    return bounds;
+}
+
+//' Filter the Lines of a File by Fixed Patterns
+//'
+//' grep -F over a memory-mapped file. The file is split into line-aligned
+//' chunks of a few MB that are matched on all threads; lines never become R
+//' strings. Line endings (LF or CRLF) are not part of the matched text.
+//' Selected lines are either returned as line numbers or written, in file
+//' order, to out_path.
+//'
+//' @param path File to read
+//' @param patterns Character vector of fixed patterns to search for, or the
+//'   external pointer of a compiled pattern set
+//' @param ignore_case Logical. Whether to ignore case. Default FALSE.
+//' @param invert Logical. Select lines matching no pattern
+//' @param out_path Output file; empty string to return line numbers instead
+//' @param n_threads Number of threads; <= 0 uses all available
+//' @param chunk_bytes Target chunk size in bytes; <= 0 uses 4 MB. Tests use
+//'   small chunks to split small files.
+//'
+//' @return List of line (1-based numbers of the selected lines, integer or
+//'   double if the file has more than .Machine$integer.max lines; empty when
+//'   writing), n_lines and n_selected
+//'
+// [[Rcpp::export]]
+Rcpp::List filter_file_cpp(std::string path,
+                           SEXP patterns,
+                           bool ignore_case = false,
+                           bool invert = false,
+                           std::string out_path = "",
+                           int n_threads = 0,
+                           int chunk_bytes = 0) {
+    const size_t CHUNK_BYTES = chunk_bytes > 0 ? static_cast<size_t>(chunk_bytes) : size_t(4) << 20;
+
+    std::unique_ptr<PatternMatcher> owned;
+    const PatternMatcher& matcher = *resolve_matcher(patterns, ignore_case, owned);
+
+    MappedFile file;
+    if (!file.open(path)) {
+        Rcpp::stop("Cannot open '%s' for reading", path);
+    }
+    const char* data = file.data();
+    const std::vector<size_t> bounds = line_aligned_chunks(data, file.size(), CHUNK_BYTES);
+    const int n_chunks = static_cast<int>(bounds.size()) - 1;
+    const bool writing = !out_path.empty();
+    std::vector<ChunkLines> chunks(n_chunks);
+
+    n_threads = std::min(resolve_threads(n_threads), std::max(n_chunks, 1));
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(n_threads) schedule(dynamic, 1)
+#endif
+    for (int c = 0; c < n_chunks; c++) {
+        ChunkLines& out = chunks[c];
+        out.n_lines = 0;
+        out.n_selected = 0;
+        const size_t end = bounds[c + 1];
+        size_t pos = bounds[c];
+
+        while (pos < end) {
+            const char* nl = static_cast<const char*>(std::memchr(data + pos, '\n', end - pos));
+            const size_t next = nl ? static_cast<size_t>(nl - data) + 1 : end;
+            size_t len = (nl ? static_cast<size_t>(nl - data) : end) - pos;
+            if (len > 0 && data[pos + len - 1] == '\r') len--;
+
+            if (matcher.any(data + pos, len) != invert) {
+                out.n_selected++;
+                if (!writing) {
+                    out.selected.push_back(out.n_lines);
+                } else if (!out.ranges.empty() && out.ranges.back().second == pos) {
+                    out.ranges.back().second = next;
+                } else {
+                    out.ranges.push_back(std::make_pair(pos, next));
+                }
+            }
+            out.n_lines++;
+            pos = next;
+        }
+    }
+
+    int64_t n_lines = 0, n_selected = 0;
+    for (int c = 0; c < n_chunks; c++) {
+        n_lines += chunks[c].n_lines;
+        n_selected += chunks[c].n_selected;
+    }
+
+    if (writing) {
+        std::FILE* out = std::fopen(out_path.c_str(), "wb");
+        if (out == NULL) {
+            Rcpp::stop("Cannot open '%s' for writing", out_path);
+        }
+        bool ok = true;
+        for (int c = 0; c < n_chunks && ok; c++) {
+            for (size_t k = 0; k < chunks[c].ranges.size() && ok; k++) {
+                const std::pair<size_t, size_t>& r = chunks[c].ranges[k];
+                ok = std::fwrite(data + r.first, 1, r.second - r.first, out) == r.second - r.first;
+                // The last line of the file may lack a newline
+                if (ok && data[r.second - 1] != '\n') ok = std::fputc('\n', out) != EOF;
+            }
+        }
+        ok = std::fclose(out) == 0 && ok;
+        if (!ok) {
+            Rcpp::stop("Failed writing filtered lines to '%s'", out_path);
+        }
+        return Rcpp::List::create(
+            Rcpp::Named("line") = Rcpp::IntegerVector(0),
+            Rcpp::Named("n_lines") = static_cast<double>(n_lines),
+            Rcpp::Named("n_selected") = static_cast<double>(n_selected)
+        );
+    }
+
+    // Chunk-local indices to 1-based file line numbers
+    Rcpp::RObject line;
+    if (n_lines <= INT_MAX) {
+        Rcpp::IntegerVector out(static_cast<R_xlen_t>(n_selected));
+        R_xlen_t k = 0;
+        int64_t first = 1;
+        for (int c = 0; c < n_chunks; c++) {
+            for (size_t j = 0; j < chunks[c].selected.size(); j++) {
+                out[k++] = static_cast<int>(first + chunks[c].selected[j]);
+            }
+            first += chunks[c].n_lines;
+        }
+        line = out;
+    } else {
+        Rcpp::NumericVector out(static_cast<R_xlen_t>(n_selected));
+        R_xlen_t k = 0;
+        int64_t first = 1;
+        for (int c = 0; c < n_chunks; c++) {
+            for (size_t j = 0; j < chunks[c].selected.size(); j++) {
+                out[k++] = static_cast<double>(first + chunks[c].selected[j]);
+            }
+            first += chunks[c].n_lines;
+        }
+        line = out;
+    }
+
+    return Rcpp::List::create(
+        Rcpp::Named("line") = line,
+        Rcpp::Named("n_lines") = static_cast<double>(n_lines),
+        Rcpp::Named("n_selected") = static_cast<double>(n_selected)
+    );
+}
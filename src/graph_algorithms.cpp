@@ -5,6 +5,12 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <algorithm>
+#include <cmath>
+#include "graph_csr.h"
+#include "compressed_graph.h"
+#include "subgraph_mask.h"
+#include "pattern_matcher.h"
+#include "parallel_utils.h"
 
 // Forward declarations to avoid conflicts
 class UnionFind {
@@ -49,15 +55,21 @@ public:
 };
 
 //' Find Connected Components
+//'
+//' Optional edge and node masks (logical vectors or packBits() bitsets)
+//' restrict the computation to a subgraph; nodes excluded by node_mask get
+//' an NA component.
 // [[Rcpp::export]]
-Rcpp::List find_components_cpp(const Rcpp::IntegerMatrix& edges, int n_nodes, bool compress = true) {
+Rcpp::List find_components_cpp(const Rcpp::IntegerMatrix& edges, int n_nodes, bool compress = true,
+                               SEXP edge_mask = R_NilValue, SEXP node_mask = R_NilValue) {
     UnionFind uf(n_nodes);
+    SubgraphMask mask(edge_mask, edges.nrow(), node_mask, n_nodes);
     
     for (int i = 0; i < edges.nrow(); i++) {
         int u = edges(i, 0) - 1;
         int v = edges(i, 1) - 1;
         
-        if (u >= 0 && u < n_nodes && v >= 0 && v < n_nodes) {
+        if (u >= 0 && u < n_nodes && v >= 0 && v < n_nodes && mask.keep(i, u, v)) {
             uf.union_sets(u, v);
         }
     }
@@ -67,6 +79,10 @@ Rcpp::List find_components_cpp(const Rcpp::IntegerMatrix& edges, int n_nodes, bo
     int next_component_id = 0;
     
     for (int i = 0; i < n_nodes; i++) {
+        if (!mask.node(i)) {
+            components[i] = NA_INTEGER;
+            continue;
+        }
         int root = uf.find(i);
         if (component_map.find(root) == component_map.end()) {
             component_map[root] = compress ? next_component_id++ : root;
@@ -76,14 +92,14 @@ Rcpp::List find_components_cpp(const Rcpp::IntegerMatrix& edges, int n_nodes, bo
     
     std::vector<int> component_sizes(next_component_id, 0);
     for (int comp : components) {
-        if (compress) {
+        if (compress && comp != NA_INTEGER) {
             component_sizes[comp]++;
         }
     }
     
     if (compress) {
         for (int& comp : components) {
-            comp++;
+            if (comp != NA_INTEGER) comp++;
         }
     }
     
@@ -95,146 +111,437 @@ Rcpp::List find_components_cpp(const Rcpp::IntegerMatrix& edges, int n_nodes, bo
 }
 
 //' Check Connectivity
+//'
+//' Unions all edges, flattens every node to its root, then answers the
+//' queries in parallel against the read-only root array.
+//'
+//' @param edges IntegerMatrix with two columns (from, to)
+//' @param query_pairs IntegerMatrix of node pairs to check
+//' @param n_nodes Number of nodes in the graph
+//' @param n_threads Number of threads; <= 0 uses all available
+//' @param edge_mask Optional logical vector or packBits() bitset of edges to keep
+//' @param node_mask Optional logical vector or packBits() bitset of nodes to keep;
+//'   queries involving an excluded node are FALSE
 // [[Rcpp::export]]
-Rcpp::LogicalVector are_connected_cpp(const Rcpp::IntegerMatrix& edges, const Rcpp::IntegerMatrix& query_pairs, int n_nodes) {
+Rcpp::LogicalVector are_connected_cpp(const Rcpp::IntegerMatrix& edges, const Rcpp::IntegerMatrix& query_pairs,
+                                      int n_nodes, int n_threads = 0,
+                                      SEXP edge_mask = R_NilValue, SEXP node_mask = R_NilValue) {
     UnionFind uf(n_nodes);
+    SubgraphMask mask(edge_mask, edges.nrow(), node_mask, n_nodes);
     
     for (int i = 0; i < edges.nrow(); i++) {
         int u = edges(i, 0) - 1;
         int v = edges(i, 1) - 1;
         
-        if (u >= 0 && u < n_nodes && v >= 0 && v < n_nodes) {
+        if (u >= 0 && u < n_nodes && v >= 0 && v < n_nodes && mask.keep(i, u, v)) {
             uf.union_sets(u, v);
         }
     }
     
-    Rcpp::LogicalVector result(query_pairs.nrow());
-    for (int i = 0; i < query_pairs.nrow(); i++) {
-        int u = query_pairs(i, 0) - 1;
-        int v = query_pairs(i, 1) - 1;
+    // find() compresses paths, so resolve all roots before going parallel
+    std::vector<int> root(n_nodes);
+    for (int i = 0; i < n_nodes; i++) {
+        root[i] = uf.find(i);
+    }
+    
+    const int n_queries = query_pairs.nrow();
+    const int* query_from = query_pairs.begin();
+    const int* query_to = query_from + n_queries;
+    Rcpp::LogicalVector result(n_queries);
+    int* result_ptr = result.begin();
+    n_threads = resolve_threads(n_threads);
+    
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(n_threads) schedule(static)
+#endif
+    for (int i = 0; i < n_queries; i++) {
+        int u = query_from[i] - 1;
+        int v = query_to[i] - 1;
         
-        if (u >= 0 && u < n_nodes && v >= 0 && v < n_nodes) {
-            result[i] = uf.connected(u, v);
+        if (u >= 0 && u < n_nodes && v >= 0 && v < n_nodes && mask.node(u) && mask.node(v)) {
+            result_ptr[i] = root[u] == root[v];
         } else {
-            result[i] = false;
+            result_ptr[i] = false;
         }
     }
     
     return result;
 }
 
-//' Shortest Paths
-// [[Rcpp::export]]
-Rcpp::IntegerVector shortest_paths_cpp(const Rcpp::IntegerMatrix& edges, const Rcpp::IntegerMatrix& query_pairs, 
-                                      int n_nodes, int max_distance) {
+// Per-thread BFS buffers, reused across all source groups a worker handles.
+// target_mark uses an epoch so it never needs clearing.
+struct BFSScratch {
+    std::vector<int> distance;
+    std::vector<int> queue;
+    std::vector<int> target_mark;
+    int epoch;
+    
+    explicit BFSScratch(int n_nodes) : distance(n_nodes, -1), queue(n_nodes), target_mark(n_nodes, 0), epoch(0) {}
+};
+
+// One BFS from `source` that stops once every target in the group has been
+// reached (or the distance limit is hit). Distances of the group's targets
+// are written to result in query order. Graph is CSRGraph or CompressedGraph.
+template <class Graph>
+static void bfs_source_group(const Graph& g, int source, const int* query_ids, int n_group,
+                             const int* query_to, int max_distance, BFSScratch& scratch,
+                             int* result) {
+    const int epoch = ++scratch.epoch;
+    int remaining = 0;
+    for (int i = 0; i < n_group; i++) {
+        int target = query_to[query_ids[i]] - 1;
+        if (scratch.target_mark[target] != epoch) {
+            scratch.target_mark[target] = epoch;
+            remaining++;
+        }
+    }
     
-    std::vector<std::vector<int>> adj(n_nodes);
+    int head = 0, tail = 0;
+    scratch.queue[tail++] = source;
+    scratch.distance[source] = 0;
     
-    for (int i = 0; i < edges.nrow(); i++) {
-        int u = edges(i, 0) - 1;
-        int v = edges(i, 1) - 1;
+    while (head < tail && remaining > 0) {
+        int current = scratch.queue[head++];
+        int d = scratch.distance[current];
         
-        if (u >= 0 && u < n_nodes && v >= 0 && v < n_nodes && u != v) {
-            adj[u].push_back(v);
-            adj[v].push_back(u);
+        if (max_distance > 0 && d >= max_distance) {
+            break;
+        }
+        
+        typename Graph::Cursor cursor = g.neighbors(current);
+        int neighbor;
+        while (cursor.next(neighbor)) {
+            if (scratch.distance[neighbor] == -1) {
+                scratch.distance[neighbor] = d + 1;
+                scratch.queue[tail++] = neighbor;
+                
+                if (scratch.target_mark[neighbor] == epoch && --remaining == 0) {
+                    break;
+                }
+            }
         }
     }
     
-    Rcpp::IntegerVector result(query_pairs.nrow());
+    for (int i = 0; i < n_group; i++) {
+        int q = query_ids[i];
+        result[q] = scratch.distance[query_to[q] - 1];
+    }
     
-    for (int q = 0; q < query_pairs.nrow(); q++) {
-        int source = query_pairs(q, 0) - 1;
-        int target = query_pairs(q, 1) - 1;
+    for (int i = 0; i < tail; i++) {
+        scratch.distance[scratch.queue[i]] = -1;
+    }
+}
+
+// Answers query_pairs on g, writing distances to result in query order.
+// Trivial queries are answered directly; the rest are grouped by source and
+// the groups distributed over threads. Queries touching a node excluded by
+// mask are unreachable.
+template <class Graph>
+static void grouped_shortest_paths(const Graph& g, int n_nodes, const Rcpp::IntegerMatrix& query_pairs,
+                                   int max_distance, int n_threads, int* result_ptr,
+                                   const SubgraphMask* mask = nullptr) {
+    const int n_queries = query_pairs.nrow();
+    const int* query_from = query_pairs.begin();
+    const int* query_to = query_from + n_queries;
+    
+    std::vector<std::pair<int, int>> pending;
+    pending.reserve(n_queries);
+    for (int q = 0; q < n_queries; q++) {
+        int source = query_from[q] - 1;
+        int target = query_to[q] - 1;
         
         if (source < 0 || source >= n_nodes || target < 0 || target >= n_nodes) {
-            result[q] = -1;
-            continue;
-        }
-        
-        if (source == target) {
-            result[q] = 0;
-            continue;
+            result_ptr[q] = -1;
+        } else if (mask != nullptr && !(mask->node(source) && mask->node(target))) {
+            result_ptr[q] = -1;
+        } else if (source == target) {
+            result_ptr[q] = 0;
+        } else {
+            pending.emplace_back(source, q);
         }
-        
-        std::vector<int> distance(n_nodes, -1);
-        std::queue<int> bfs_queue;
-        
-        distance[source] = 0;
-        bfs_queue.push(source);
-        
-        bool found = false;
-        while (!bfs_queue.empty() && !found) {
-            int current = bfs_queue.front();
-            bfs_queue.pop();
-            
-            if (max_distance > 0 && distance[current] >= max_distance) {
-                break;
-            }
-            
-            for (int neighbor : adj[current]) {
-                if (distance[neighbor] == -1) {
-                    distance[neighbor] = distance[current] + 1;
-                    
-                    if (neighbor == target) {
-                        result[q] = distance[neighbor];
-                        found = true;
-                        break;
-                    }
-                    
-                    bfs_queue.push(neighbor);
-                }
-            }
+    }
+    
+    std::sort(pending.begin(), pending.end());
+    
+    std::vector<int> query_ids(pending.size());
+    std::vector<int> group_start;
+    for (size_t i = 0; i < pending.size(); i++) {
+        query_ids[i] = pending[i].second;
+        if (i == 0 || pending[i].first != pending[i - 1].first) {
+            group_start.push_back(static_cast<int>(i));
         }
+    }
+    group_start.push_back(static_cast<int>(pending.size()));
+    
+    const int n_groups = static_cast<int>(group_start.size()) - 1;
+    n_threads = resolve_threads(n_threads);
+    if (n_threads > n_groups) n_threads = n_groups > 0 ? n_groups : 1;
+    
+#ifdef _OPENMP
+#pragma omp parallel num_threads(n_threads)
+#endif
+    {
+        BFSScratch scratch(n_groups > 0 ? n_nodes : 0);
         
-        if (!found) {
-            result[q] = -1;
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1)
+#endif
+        for (int grp = 0; grp < n_groups; grp++) {
+            int begin = group_start[grp];
+            int source = pending[begin].first;
+            bfs_source_group(g, source, &query_ids[begin], group_start[grp + 1] - begin,
+                             query_to, max_distance, scratch, result_ptr);
         }
     }
+}
+
+//' Shortest Paths
+//'
+//' Unweighted shortest path distances. Queries are grouped by source so a
+//' single BFS answers every target sharing that source, and source groups
+//' are distributed over threads, each with its own reusable BFS buffers.
+//' Results are returned in input query order.
+//'
+//' @param edges IntegerMatrix with two columns (from, to)
+//' @param query_pairs IntegerMatrix of (source, target) pairs
+//' @param n_nodes Number of nodes in the graph
+//' @param max_distance Maximum distance to search; <= 0 means no limit
+//' @param n_threads Number of threads; <= 0 uses all available
+//' @param edge_mask Optional logical vector or packBits() bitset of edges to keep
+//' @param node_mask Optional logical vector or packBits() bitset of nodes to keep
+// [[Rcpp::export]]
+Rcpp::IntegerVector shortest_paths_cpp(const Rcpp::IntegerMatrix& edges, const Rcpp::IntegerMatrix& query_pairs, 
+                                      int n_nodes, int max_distance, int n_threads = 0,
+                                      SEXP edge_mask = R_NilValue, SEXP node_mask = R_NilValue) {
+    
+    const int* from = edges.begin();
+    const int* to = from + edges.nrow();
+    SubgraphMask mask(edge_mask, edges.nrow(), node_mask, n_nodes);
+    CSRGraph g = build_csr(from, to, edges.nrow(), n_nodes, nullptr, &mask);
+    
+    Rcpp::IntegerVector result(query_pairs.nrow());
+    grouped_shortest_paths(g, n_nodes, query_pairs, max_distance, n_threads, result.begin(), &mask);
     
     return result;
 }
 
-//' Graph Statistics
+//' Shortest Paths on a Compressed Graph
+//'
+//' Same as shortest_paths_cpp, but BFS decodes the gap-encoded adjacency
+//' lists of a graph built by compress_graph_cpp.
+//'
+//' @param graph_ptr External pointer returned by compress_graph_cpp
+//' @param query_pairs IntegerMatrix of (source, target) pairs
+//' @param max_distance Maximum distance to search; <= 0 means no limit
+//' @param n_threads Number of threads; <= 0 uses all available
 // [[Rcpp::export]]
-Rcpp::List graph_stats_cpp(const Rcpp::IntegerMatrix& edges, int n_nodes) {
-    std::vector<int> degree(n_nodes, 0);
-    int n_edges = edges.nrow();
+Rcpp::IntegerVector compressed_shortest_paths_cpp(SEXP graph_ptr, const Rcpp::IntegerMatrix& query_pairs,
+                                                  int max_distance, int n_threads = 0) {
+    const CompressedGraph* g = get_compressed_graph(graph_ptr);
     
-    for (int i = 0; i < n_edges; i++) {
-        int u = edges(i, 0) - 1;
-        int v = edges(i, 1) - 1;
-        
-        if (u >= 0 && u < n_nodes && v >= 0 && v < n_nodes && u != v) {
-            degree[u]++;
-            degree[v]++;
+    Rcpp::IntegerVector result(query_pairs.nrow());
+    grouped_shortest_paths(*g, g->n_nodes, query_pairs, max_distance, n_threads, result.begin());
+    
+    return result;
+}
+
+// Degree at or below which a fraction p of nodes fall (inverse empirical CDF)
+static int degree_percentile(const std::vector<int>& histogram, double n_nodes, double p) {
+    double needed = p * n_nodes;
+    double cumulative = 0.0;
+    for (size_t d = 0; d < histogram.size(); d++) {
+        cumulative += histogram[d];
+        if (cumulative >= needed) {
+            return static_cast<int>(d);
         }
     }
+    return histogram.empty() ? 0 : static_cast<int>(histogram.size()) - 1;
+}
+
+// Degree histogram and summaries shared by graph_stats_cpp and
+// compressed_graph_stats_cpp
+static Rcpp::List graph_stats_result(const std::vector<int>& degree, int n_nodes, int64_t n_edges,
+                                     int64_t n_simple_edges, int64_t n_self_loops,
+                                     int64_t n_duplicates, int64_t n_invalid) {
+    int min_degree = 0, max_degree = 0;
+    double mean_degree = 0.0, sd_degree = 0.0;
+    int n_isolated = 0;
+    if (n_nodes > 0) {
+        min_degree = *std::min_element(degree.begin(), degree.end());
+        max_degree = *std::max_element(degree.begin(), degree.end());
+    }
     
-    int min_degree = *std::min_element(degree.begin(), degree.end());
-    int max_degree = *std::max_element(degree.begin(), degree.end());
-    double mean_degree = 0.0;
+    std::vector<int> histogram(static_cast<size_t>(max_degree) + 1, 0);
     for (int d : degree) {
+        histogram[d]++;
         mean_degree += d;
+        if (d == 0) n_isolated++;
+    }
+    if (n_nodes > 0) {
+        mean_degree /= n_nodes;
+        for (size_t d = 0; d < histogram.size(); d++) {
+            double diff = static_cast<double>(d) - mean_degree;
+            sd_degree += histogram[d] * diff * diff;
+        }
+        sd_degree = n_nodes > 1 ? std::sqrt(sd_degree / (n_nodes - 1)) : 0.0;
     }
-    mean_degree /= n_nodes;
+    
+    const double probs[] = {0.01, 0.05, 0.25, 0.50, 0.75, 0.95, 0.99};
+    const char* prob_names[] = {"1%", "5%", "25%", "50%", "75%", "95%", "99%"};
+    Rcpp::NumericVector percentiles(7);
+    Rcpp::CharacterVector percentile_names(7);
+    for (int i = 0; i < 7; i++) {
+        percentiles[i] = degree_percentile(histogram, n_nodes, probs[i]);
+        percentile_names[i] = prob_names[i];
+    }
+    percentiles.attr("names") = percentile_names;
     
     double max_possible_edges = (double)n_nodes * (n_nodes - 1) / 2.0;
-    double density = (max_possible_edges > 0) ? n_edges / max_possible_edges : 0.0;
+    double density = (max_possible_edges > 0) ? n_simple_edges / max_possible_edges : 0.0;
     
     Rcpp::List degree_stats = Rcpp::List::create(
         Rcpp::Named("min") = min_degree,
         Rcpp::Named("max") = max_degree,
-        Rcpp::Named("mean") = mean_degree
+        Rcpp::Named("mean") = mean_degree,
+        Rcpp::Named("median") = percentiles[3],
+        Rcpp::Named("sd") = sd_degree,
+        Rcpp::Named("percentiles") = percentiles
     );
     
     return Rcpp::List::create(
-        Rcpp::Named("n_edges") = n_edges,
+        Rcpp::Named("n_edges") = (int)n_edges,
         Rcpp::Named("n_nodes") = n_nodes,
         Rcpp::Named("density") = density,
-        Rcpp::Named("degree_stats") = degree_stats
+        Rcpp::Named("degree_stats") = degree_stats,
+        Rcpp::Named("n_simple_edges") = (int)n_simple_edges,
+        Rcpp::Named("n_self_loops") = (int)n_self_loops,
+        Rcpp::Named("n_duplicate_edges") = (int)n_duplicates,
+        Rcpp::Named("n_invalid_edges") = (int)n_invalid,
+        Rcpp::Named("n_isolated") = n_isolated,
+        Rcpp::Named("degree_histogram") = histogram
     );
 }
 
+//' Graph Statistics
+//'
+//' Degree and edge-quality statistics in one parallel pass over the edge
+//' matrix. Each thread counts self-loops and invalid edges, increments
+//' degrees, and files canonical (min, max) edge keys into buckets by node
+//' range. Buckets are then sorted in parallel to count duplicate edges, which
+//' gives the simple-graph edge count used for density.
+//'
+//' @param edges IntegerMatrix with two columns (from, to)
+//' @param n_nodes Number of nodes in the graph
+//' @param n_threads Number of threads; <= 0 uses all available
+//' @return List with edge counts, density, isolated node count, degree
+//'   summary, percentiles and the degree histogram
+// [[Rcpp::export]]
+Rcpp::List graph_stats_cpp(const Rcpp::IntegerMatrix& edges, int n_nodes, int n_threads = 0) {
+    const int64_t n_edges = edges.nrow();
+    const int* from = edges.begin();
+    const int* to = from + n_edges;
+    n_threads = resolve_threads(n_threads);
+    
+    const int n_buckets = n_nodes > 0 ? std::max(1, std::min(4 * n_threads, n_nodes)) : 1;
+    std::vector<int> degree(n_nodes, 0);
+    std::vector<std::vector<std::vector<uint64_t>>> thread_keys(
+        n_threads, std::vector<std::vector<uint64_t>>(n_buckets));
+    int64_t n_self_loops = 0, n_invalid = 0;
+    
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(n_threads) schedule(static) reduction(+:n_self_loops,n_invalid)
+#endif
+    for (int64_t i = 0; i < n_edges; i++) {
+        if (from[i] == NA_INTEGER || to[i] == NA_INTEGER) {
+            n_invalid++;
+            continue;
+        }
+        
+        int u = from[i] - 1;
+        int v = to[i] - 1;
+        
+        if (u < 0 || u >= n_nodes || v < 0 || v >= n_nodes) {
+            n_invalid++;
+            continue;
+        }
+        if (u == v) {
+            n_self_loops++;
+            continue;
+        }
+        
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+        degree[u]++;
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+        degree[v]++;
+        
+        uint64_t lo = static_cast<uint64_t>(std::min(u, v));
+        uint64_t hi = static_cast<uint64_t>(std::max(u, v));
+        int bucket = static_cast<int>(lo * n_buckets / n_nodes);
+        thread_keys[current_thread()][bucket].push_back((lo << 32) | hi);
+    }
+    
+    // Duplicate detection: sort each node-range bucket independently
+    int64_t n_simple_edges = 0;
+    
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(n_threads) schedule(dynamic, 1) reduction(+:n_simple_edges)
+#endif
+    for (int b = 0; b < n_buckets; b++) {
+        std::vector<uint64_t> keys;
+        size_t total = 0;
+        for (int t = 0; t < n_threads; t++) total += thread_keys[t][b].size();
+        keys.reserve(total);
+        for (int t = 0; t < n_threads; t++) {
+            keys.insert(keys.end(), thread_keys[t][b].begin(), thread_keys[t][b].end());
+            std::vector<uint64_t>().swap(thread_keys[t][b]);
+        }
+        
+        std::sort(keys.begin(), keys.end());
+        n_simple_edges += std::unique(keys.begin(), keys.end()) - keys.begin();
+    }
+    
+    const int64_t n_valid = n_edges - n_invalid - n_self_loops;
+    const int64_t n_duplicates = n_valid - n_simple_edges;
+    
+    return graph_stats_result(degree, n_nodes, n_edges, n_simple_edges, n_self_loops,
+                              n_duplicates, n_invalid);
+}
+
+//' Graph Statistics for a Compressed Graph
+//'
+//' Degree statistics read from the list headers of a graph built by
+//' compress_graph_cpp. Lists are deduplicated, so degrees are simple-graph
+//' degrees; edge-quality counts are the ones recorded at build time.
+//'
+//' @param graph_ptr External pointer returned by compress_graph_cpp
+//' @param n_threads Number of threads; <= 0 uses all available
+//' @return Same list structure as graph_stats_cpp
+// [[Rcpp::export]]
+Rcpp::List compressed_graph_stats_cpp(SEXP graph_ptr, int n_threads = 0) {
+    const CompressedGraph* g = get_compressed_graph(graph_ptr);
+    const int n_nodes = g->n_nodes;
+    n_threads = resolve_threads(n_threads);
+    
+    std::vector<int> degree(n_nodes);
+    int64_t n_entries = 0;
+    
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(n_threads) schedule(static) reduction(+:n_entries)
+#endif
+    for (int u = 0; u < n_nodes; u++) {
+        degree[u] = g->degree(u);
+        n_entries += degree[u];
+    }
+    
+    return graph_stats_result(degree, n_nodes, static_cast<int64_t>(g->n_input_edges), n_entries / 2,
+                              static_cast<int64_t>(g->n_self_loops), static_cast<int64_t>(g->n_duplicates),
+                              static_cast<int64_t>(g->n_invalid));
+}
+
 //' Get Edge Component Assignments
 //' 
 //' Efficiently returns component ID for each edge (both from and to nodes).
@@ -303,16 +610,65 @@ Rcpp::List get_edge_components_cpp(const Rcpp::IntegerMatrix& edges, int n_nodes
     );
 }
 
+// Sets row[pattern * stride] for every match, i.e. one row of a column-major
+// string x pattern logical matrix
+struct MarkMatch {
+    int* row;
+    R_xlen_t stride;
+    void operator()(int pattern, size_t) { row[pattern * stride] = TRUE; }
+};
+
+// TRUE for every string containing at least one pattern. Repeated strings
+// are matched once and the result broadcast (see StringRefs).
+static Rcpp::LogicalVector any_pattern_matches(const Rcpp::CharacterVector& strings,
+                                               SEXP patterns, bool ignore_case, int n_threads) {
+    std::unique_ptr<PatternMatcher> owned;
+    const PatternMatcher& matcher = *resolve_matcher(patterns, ignore_case, owned);
+    const StringRefs refs(strings, true);
+    const R_xlen_t n_match = refs.size();
+#ifdef _OPENMP
+    // The broadcast below spans all elements, not just the distinct ones
+    const int copy_threads = matching_threads(n_threads, refs.n_elements);
+#endif
+    n_threads = matching_threads(n_threads, n_match);
+    
+    Rcpp::LogicalVector result(refs.n_elements);
+    std::vector<int> distinct_hits(refs.deduplicated() ? n_match : 0);
+    int* hits = refs.deduplicated() ? distinct_hits.data() : LOGICAL(result);
+    
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(n_threads) schedule(dynamic, 1024)
+#endif
+    for (R_xlen_t i = 0; i < n_match; i++) {
+        hits[i] = matcher.any(refs.data[i], refs.length[i]);
+    }
+    
+    if (refs.deduplicated()) {
+        int* out = LOGICAL(result);
+        const int* index = refs.index.data();
+        const R_xlen_t n_elements = refs.n_elements;
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(copy_threads) schedule(static)
+#endif
+        for (R_xlen_t i = 0; i < n_elements; i++) {
+            out[i] = hits[index[i]];
+        }
+    }
+    return result;
+}
+
 //' Multi-Pattern Fixed String Matching
 //'
 //' Fast C++ implementation for finding multiple fixed patterns in strings.
 //' Equivalent to multiple grepl(pattern, x, fixed=TRUE) calls but much faster.
 //'
 //' @param strings Character vector of strings to search in
-//' @param patterns Character vector of fixed patterns to search for
+//' @param patterns Character vector of fixed patterns to search for, or the
+//'   external pointer of a compiled pattern set (whose ignore_case is used)
 //' @param match_any Logical. If TRUE, returns TRUE if ANY pattern matches.
 //'   If FALSE, returns a matrix showing which pattern matches which string.
 //' @param ignore_case Logical. Whether to ignore case when matching. Default FALSE.
+//' @param n_threads Number of threads; <= 0 uses all available
 //'
 //' @return If match_any=TRUE: Logical vector same length as strings.
 //'   If match_any=FALSE: Logical matrix with nrow=length(strings), ncol=length(patterns).
@@ -331,67 +687,122 @@ Rcpp::List get_edge_components_cpp(const Rcpp::IntegerMatrix& edges, int n_nodes
 //'
 // [[Rcpp::export]]
 Rcpp::LogicalMatrix multi_grepl_cpp(const Rcpp::CharacterVector& strings,
-                                   const Rcpp::CharacterVector& patterns,
+                                   SEXP patterns,
                                    bool match_any = true,
-                                   bool ignore_case = false) {
+                                   bool ignore_case = false,
+                                   int n_threads = 0) {
     
-    int n_strings = strings.size();
-    int n_patterns = patterns.size();
+    if (match_any) {
+        // n x 1 matrix for a consistent return type
+        Rcpp::LogicalVector any = any_pattern_matches(strings, patterns, ignore_case, n_threads);
+        Rcpp::LogicalMatrix result(any.size(), 1);
+        std::copy(any.begin(), any.end(), result.begin());
+        return result;
+    }
     
-    // Convert patterns to std::string for easier manipulation
-    std::vector<std::string> pattern_vec(n_patterns);
-    for (int p = 0; p < n_patterns; p++) {
-        pattern_vec[p] = Rcpp::as<std::string>(patterns[p]);
-        if (ignore_case) {
-            // Convert pattern to lowercase
-            std::transform(pattern_vec[p].begin(), pattern_vec[p].end(), 
-                         pattern_vec[p].begin(), ::tolower);
-        }
+    std::unique_ptr<PatternMatcher> owned;
+    const PatternMatcher& matcher = *resolve_matcher(patterns, ignore_case, owned);
+    const StringRefs refs(strings);
+    const R_xlen_t n_strings = refs.size();
+    n_threads = matching_threads(n_threads, n_strings);
+    
+    // One automaton pass per string marks every pattern that occurs in it;
+    // blocks of consecutive strings keep threads on separate cache lines
+    Rcpp::LogicalMatrix result(n_strings, matcher.n_patterns());
+    std::fill(result.begin(), result.end(), FALSE);
+    int* out = LOGICAL(result);
+    
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(n_threads) schedule(dynamic, 1024)
+#endif
+    for (R_xlen_t i = 0; i < n_strings; i++) {
+        MarkMatch mark = { out + i, n_strings };
+        matcher.for_each_match(refs.data[i], refs.length[i], mark);
     }
     
-    if (match_any) {
-        // Return vector indicating if ANY pattern matches each string
-        Rcpp::LogicalVector result(n_strings);
+    return result;
+}
+
+//' Multi-Pattern Matches as Sparse Pairs
+//'
+//' Same information as multi_grepl_cpp(match_any = FALSE) without the dense
+//' matrix: one automaton pass per string reports every pattern it contains,
+//' and only those (string, pattern) pairs are returned.
+//'
+//' @param strings Character vector of strings to search in
+//' @param patterns Character vector of fixed patterns to search for, or the
+//'   external pointer of a compiled pattern set
+//' @param ignore_case Logical. Whether to ignore case. Default FALSE.
+//' @param n_threads Number of threads; <= 0 uses all available
+//'
+//' @return List with integer vectors string and pattern (1-based), ordered by
+//'   string and then pattern, each pair listed once
+//'
+// [[Rcpp::export]]
+Rcpp::List multi_grepl_pairs_cpp(const Rcpp::CharacterVector& strings,
+                                 SEXP patterns,
+                                 bool ignore_case = false,
+                                 int n_threads = 0) {
+    
+    std::unique_ptr<PatternMatcher> owned;
+    const PatternMatcher& matcher = *resolve_matcher(patterns, ignore_case, owned);
+    const StringRefs refs(strings);
+    const R_xlen_t n_strings = refs.size();
+    const int n_patterns = matcher.n_patterns();
+    n_threads = matching_threads(n_threads, n_strings);
+    
+    // Blocks of strings are matched independently into their own buffers
+    // and concatenated in block order
+    const R_xlen_t BLOCK = 4096;
+    const R_xlen_t n_blocks = (n_strings + BLOCK - 1) / BLOCK;
+    std::vector<std::vector<int>> block_strings(n_blocks), block_patterns(n_blocks);
+    
+#ifdef _OPENMP
+#pragma omp parallel num_threads(n_threads)
+#endif
+    {
+        // Per-thread stamp of the last string each pattern was reported for
+        std::vector<R_xlen_t> seen(n_patterns, -1);
+        std::vector<int> found;
         
-        for (int i = 0; i < n_strings; i++) {
-            std::string str = Rcpp::as<std::string>(strings[i]);
-            if (ignore_case) {
-                std::transform(str.begin(), str.end(), str.begin(), ::tolower);
-            }
-            
-            bool found_match = false;
-            for (int p = 0; p < n_patterns && !found_match; p++) {
-                if (str.find(pattern_vec[p]) != std::string::npos) {
-                    found_match = true;
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1)
+#endif
+        for (R_xlen_t b = 0; b < n_blocks; b++) {
+            const R_xlen_t end = std::min(n_strings, (b + 1) * BLOCK);
+            for (R_xlen_t i = b * BLOCK; i < end; i++) {
+                found.clear();
+                auto collect = [&](int pattern, size_t) {
+                    if (seen[pattern] != i) {
+                        seen[pattern] = i;
+                        found.push_back(pattern);
+                    }
+                };
+                matcher.for_each_match(refs.data[i], refs.length[i], collect);
+                std::sort(found.begin(), found.end());
+                for (size_t k = 0; k < found.size(); k++) {
+                    block_strings[b].push_back(static_cast<int>(i) + 1);
+                    block_patterns[b].push_back(found[k] + 1);
                 }
             }
-            result[i] = found_match;
         }
-        
-        // Convert to matrix format for consistent return type
-        Rcpp::LogicalMatrix result_matrix(n_strings, 1);
-        for (int i = 0; i < n_strings; i++) {
-            result_matrix(i, 0) = result[i];
-        }
-        return result_matrix;
-        
-    } else {
-        // Return matrix showing which patterns match which strings
-        Rcpp::LogicalMatrix result(n_strings, n_patterns);
-        
-        for (int i = 0; i < n_strings; i++) {
-            std::string str = Rcpp::as<std::string>(strings[i]);
-            if (ignore_case) {
-                std::transform(str.begin(), str.end(), str.begin(), ::tolower);
-            }
-            
-            for (int p = 0; p < n_patterns; p++) {
-                result(i, p) = (str.find(pattern_vec[p]) != std::string::npos);
-            }
-        }
-        
-        return result;
     }
+    
+    R_xlen_t n_pairs = 0;
+    for (R_xlen_t b = 0; b < n_blocks; b++) n_pairs += block_strings[b].size();
+    
+    Rcpp::IntegerVector res_string(n_pairs), res_pattern(n_pairs);
+    R_xlen_t pos = 0;
+    for (R_xlen_t b = 0; b < n_blocks; b++) {
+        std::copy(block_strings[b].begin(), block_strings[b].end(), res_string.begin() + pos);
+        std::copy(block_patterns[b].begin(), block_patterns[b].end(), res_pattern.begin() + pos);
+        pos += block_strings[b].size();
+    }
+    
+    return Rcpp::List::create(
+        Rcpp::Named("string") = res_string,
+        Rcpp::Named("pattern") = res_pattern
+    );
 }
 
 //' Multi-Pattern Fixed String Matching (Any Match)
@@ -400,140 +811,49 @@ Rcpp::LogicalMatrix multi_grepl_cpp(const Rcpp::CharacterVector& strings,
 //' Optimized for the common use case of "does this string contain any of these patterns?"
 //'
 //' @param strings Character vector of strings to search in
-//' @param patterns Character vector of fixed patterns to search for
+//' @param patterns Character vector of fixed patterns to search for, or the
+//'   external pointer of a compiled pattern set
 //' @param ignore_case Logical. Whether to ignore case. Default FALSE.
+//' @param n_threads Number of threads; <= 0 uses all available
 //'
 //' @return Logical vector same length as strings
 //'
 // [[Rcpp::export]]
 Rcpp::LogicalVector multi_grepl_any_cpp(const Rcpp::CharacterVector& strings,
-                                        const Rcpp::CharacterVector& patterns,
-                                        bool ignore_case = false) {
-    
-    int n_strings = strings.size();
-    int n_patterns = patterns.size();
-    
-    // Convert patterns to std::string
-    std::vector<std::string> pattern_vec(n_patterns);
-    for (int p = 0; p < n_patterns; p++) {
-        pattern_vec[p] = Rcpp::as<std::string>(patterns[p]);
-        if (ignore_case) {
-            std::transform(pattern_vec[p].begin(), pattern_vec[p].end(), 
-                         pattern_vec[p].begin(), ::tolower);
-        }
-    }
-    
-    Rcpp::LogicalVector result(n_strings);
-    
-    for (int i = 0; i < n_strings; i++) {
-        std::string str = Rcpp::as<std::string>(strings[i]);
-        if (ignore_case) {
-            std::transform(str.begin(), str.end(), str.begin(), ::tolower);
-        }
-        
-        bool found_match = false;
-        for (int p = 0; p < n_patterns && !found_match; p++) {
-            if (str.find(pattern_vec[p]) != std::string::npos) {
-                found_match = true;
-            }
-        }
-        result[i] = found_match;
-    }
-    
-    return result;
+                                        SEXP patterns,
+                                        bool ignore_case = false,
+                                        int n_threads = 0) {
+    return any_pattern_matches(strings, patterns, ignore_case, n_threads);
 }
 
 //' Multi-Pattern Fixed String Matching (Any Match) - Optimized Version
 //'
-//' High-performance version with multiple optimizations:
-//' - Minimal string conversions using CHAR() and strstr()
-//' - Pattern sorting by length for early termination  
-//' - Chunked processing for better cache locality
-//' - Optimized case conversion without std::transform
+//' High-performance version:
+//' - Reads strings in place with CHAR() and their stored length, no copies
+//' - One pattern: AVX2/SSE2 first-and-last-byte search
+//' - Up to 64 patterns: Teddy packed-nibble literal matcher (SSSE3)
+//' - Larger sets: one Aho-Corasick scan per string, whatever the number of
+//'   patterns
+//' - Case folding in SIMD registers or through a byte table, never by copying
+//' - CPU features detected at runtime, with scalar fallbacks
+//' - Strings split across threads; CHAR() pointers are gathered first so
+//'   workers never touch the R API
+//' - Repeated strings (same interned CHARSXP) matched once
 //'
 //' @param strings Character vector of strings to search in
-//' @param patterns Character vector of fixed patterns to search for
+//' @param patterns Character vector of fixed patterns to search for, or the
+//'   external pointer of a compiled pattern set
 //' @param ignore_case Logical. Whether to ignore case. Default FALSE.
+//' @param n_threads Number of threads; <= 0 uses all available
 //'
 //' @return Logical vector same length as strings
 //'
 // [[Rcpp::export]]
 Rcpp::LogicalVector multi_grepl_any_fast_cpp(const Rcpp::CharacterVector& strings,
-                                             const Rcpp::CharacterVector& patterns,
-                                             bool ignore_case = false) {
-    
-    int n_strings = strings.size();
-    int n_patterns = patterns.size();
-    
-    // Early exit for empty patterns
-    if (n_patterns == 0) {
-        return Rcpp::LogicalVector(n_strings, false);
-    }
-    
-    // Convert and sort patterns by length (shorter first for faster rejection)
-    std::vector<std::pair<std::string, int>> pattern_data;
-    pattern_data.reserve(n_patterns);
-    
-    for (int p = 0; p < n_patterns; p++) {
-        std::string pattern = Rcpp::as<std::string>(patterns[p]);
-        if (ignore_case) {
-            // Fast case conversion
-            for (char& c : pattern) {
-                if (c >= 'A' && c <= 'Z') {
-                    c += 32;
-                }
-            }
-        }
-        pattern_data.emplace_back(std::move(pattern), pattern.length());
-    }
-    
-    // Sort by length for early termination
-    std::sort(pattern_data.begin(), pattern_data.end(), 
-              [](const std::pair<std::string, int>& a, const std::pair<std::string, int>& b) { 
-                  return a.second < b.second; 
-              });
-    
-    Rcpp::LogicalVector result(n_strings);
-    
-    for (int i = 0; i < n_strings; i++) {
-        const char* str_ptr = CHAR(strings[i]);
-        int str_len = strlen(str_ptr);
-        bool found_match = false;
-        
-        if (ignore_case) {
-            // Convert string once
-            std::string str_lower;
-            str_lower.reserve(str_len);
-            for (int j = 0; j < str_len; j++) {
-                char c = str_ptr[j];
-                str_lower += (c >= 'A' && c <= 'Z') ? (c + 32) : c;
-            }
-            
-            // Search patterns
-            for (size_t p = 0; p < pattern_data.size(); p++) {
-                const std::pair<std::string, int>& pattern_pair = pattern_data[p];
-                if (pattern_pair.second > str_len) break;
-                if (str_lower.find(pattern_pair.first) != std::string::npos) {
-                    found_match = true;
-                    break;
-                }
-            }
-        } else {
-            // Case-sensitive: use fast C-style search
-            for (size_t p = 0; p < pattern_data.size(); p++) {
-                const std::pair<std::string, int>& pattern_pair = pattern_data[p];
-                if (pattern_pair.second > str_len) break;
-                if (strstr(str_ptr, pattern_pair.first.c_str()) != nullptr) {
-                    found_match = true;
-                    break;
-                }
-            }
-        }
-        
-        result[i] = found_match;
-    }
-    
-    return result;
+                                             SEXP patterns,
+                                             bool ignore_case = false,
+                                             int n_threads = 0) {
+    return any_pattern_matches(strings, patterns, ignore_case, n_threads);
 }
 
 //' Multi-Column Group ID Assignment
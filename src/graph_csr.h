@@ -0,0 +1,96 @@
+#ifndef GRAPHFAST_GRAPH_CSR_H
+#define GRAPHFAST_GRAPH_CSR_H
+
+#include <vector>
+#include <cstdint>
+#include "subgraph_mask.h"
+
+// Compressed sparse row adjacency for an undirected graph.
+//
+// Built straight from the column-major storage of an R edge matrix
+// (1-based node IDs). Invalid endpoints and self-loops are dropped, the same
+// way shortest_paths_cpp treats them. Each edge is stored in both directions.
+struct CSRGraph {
+    int n_nodes;
+    std::vector<int64_t> offsets;  // n_nodes + 1
+    std::vector<int> targets;      // 2 * valid edges
+    std::vector<double> weights;   // parallel to targets, empty if unweighted
+
+    CSRGraph() : n_nodes(0), offsets(1, 0) {}
+
+    int64_t begin(int u) const { return offsets[u]; }
+    int64_t end(int u) const { return offsets[u + 1]; }
+    int degree(int u) const { return static_cast<int>(offsets[u + 1] - offsets[u]); }
+    bool weighted() const { return !weights.empty(); }
+
+    // Neighbor cursor, the iteration interface shared with CompressedGraph
+    struct Cursor {
+        const int* p;
+        const int* last;
+
+        bool next(int& v) {
+            if (p == last) return false;
+            v = *p++;
+            return true;
+        }
+    };
+
+    Cursor neighbors(int u) const {
+        Cursor c;
+        c.p = targets.data() + offsets[u];
+        c.last = targets.data() + offsets[u + 1];
+        return c;
+    }
+};
+
+// from/to point at the two columns of an n_edges x 2 integer matrix.
+// weights may be null for an unweighted graph; mask, if given, drops the
+// edges it excludes.
+inline CSRGraph build_csr(const int* from, const int* to, int64_t n_edges, int n_nodes,
+                          const double* weights = nullptr, const SubgraphMask* mask = nullptr) {
+    CSRGraph g;
+    g.n_nodes = n_nodes;
+    g.offsets.assign(static_cast<size_t>(n_nodes) + 1, 0);
+
+    // Counting pass
+    for (int64_t i = 0; i < n_edges; i++) {
+        int u = from[i] - 1;
+        int v = to[i] - 1;
+        if (u >= 0 && u < n_nodes && v >= 0 && v < n_nodes && u != v &&
+            (mask == nullptr || mask->keep(i, u, v))) {
+            g.offsets[u + 1]++;
+            g.offsets[v + 1]++;
+        }
+    }
+
+    for (int i = 0; i < n_nodes; i++) {
+        g.offsets[i + 1] += g.offsets[i];
+    }
+
+    g.targets.resize(static_cast<size_t>(g.offsets[n_nodes]));
+    if (weights != nullptr) {
+        g.weights.resize(g.targets.size());
+    }
+
+    // Fill pass
+    std::vector<int64_t> cursor(g.offsets.begin(), g.offsets.end() - 1);
+    for (int64_t i = 0; i < n_edges; i++) {
+        int u = from[i] - 1;
+        int v = to[i] - 1;
+        if (u >= 0 && u < n_nodes && v >= 0 && v < n_nodes && u != v &&
+            (mask == nullptr || mask->keep(i, u, v))) {
+            int64_t pu = cursor[u]++;
+            int64_t pv = cursor[v]++;
+            g.targets[pu] = v;
+            g.targets[pv] = u;
+            if (weights != nullptr) {
+                g.weights[pu] = weights[i];
+                g.weights[pv] = weights[i];
+            }
+        }
+    }
+
+    return g;
+}
+
+#endif
@@ -0,0 +1,207 @@
+#include <Rcpp.h>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include "graph_csr.h"
+#include "parallel_utils.h"
+
+// Per-thread BFS buffers. `stamp` marks nodes visited by the current BFS so
+// distances never need clearing between runs.
+struct EccentricityScratch {
+    std::vector<int> stamp;
+    std::vector<int> distance;
+    std::vector<int> queue;
+    int epoch;
+
+    explicit EccentricityScratch(int n_nodes)
+        : stamp(n_nodes, 0), distance(n_nodes, 0), queue(n_nodes), epoch(0) {}
+};
+
+// BFS from source; returns its eccentricity and the last node reached (a
+// farthest node). The visit order stays in scratch.queue[0, visited).
+static int bfs_eccentricity(const CSRGraph& g, int source, EccentricityScratch& scratch,
+                            int& farthest, int& visited) {
+    const int epoch = ++scratch.epoch;
+    int head = 0, tail = 0;
+    scratch.queue[tail++] = source;
+    scratch.stamp[source] = epoch;
+    scratch.distance[source] = 0;
+
+    while (head < tail) {
+        int u = scratch.queue[head++];
+        int du = scratch.distance[u];
+        for (int64_t e = g.begin(u); e < g.end(u); e++) {
+            int v = g.targets[e];
+            if (scratch.stamp[v] != epoch) {
+                scratch.stamp[v] = epoch;
+                scratch.distance[v] = du + 1;
+                scratch.queue[tail++] = v;
+            }
+        }
+    }
+
+    farthest = scratch.queue[tail - 1];
+    visited = tail;
+    return scratch.distance[farthest];
+}
+
+struct DiameterResult {
+    int lower;
+    int upper;
+    int n_bfs;
+    bool exact;
+};
+
+// Diameter of the component containing `nodes`.
+//
+// A double sweep from the highest-degree node gives a lower bound, then iFUB
+// (Crescenzi et al., 2013) walks the BFS levels of that node from the
+// outside in: once the best eccentricity seen exceeds 2(i - 1) no deeper
+// node can improve it. If the BFS budget runs out the double-sweep / partial
+// iFUB lower bound is returned together with the current upper bound.
+static DiameterResult component_diameter(const CSRGraph& g, const int* nodes, int size,
+                                         int max_bfs, EccentricityScratch& scratch) {
+    DiameterResult res;
+    res.lower = 0;
+    res.upper = 0;
+    res.n_bfs = 0;
+    res.exact = true;
+    if (size <= 1) return res;
+
+    int hub = nodes[0];
+    for (int i = 1; i < size; i++) {
+        if (g.degree(nodes[i]) > g.degree(hub)) hub = nodes[i];
+    }
+
+    int farthest, visited;
+    int ecc_hub = bfs_eccentricity(g, hub, scratch, farthest, visited);
+
+    // Keep the hub's BFS levels (nodes in nondecreasing distance) for iFUB
+    std::vector<int> level_nodes(scratch.queue.begin(), scratch.queue.begin() + visited);
+    std::vector<int> level_dist(visited);
+    for (int i = 0; i < visited; i++) {
+        level_dist[i] = scratch.distance[level_nodes[i]];
+    }
+
+    int sweep_end, sweep_visited;
+    res.lower = std::max(ecc_hub, bfs_eccentricity(g, farthest, scratch, sweep_end, sweep_visited));
+    res.upper = std::min(2 * ecc_hub, size - 1);
+    res.n_bfs = 2;
+
+    if (res.lower >= res.upper) {
+        res.upper = res.lower;
+        return res;
+    }
+
+    int pos = visited - 1;
+    for (int level = ecc_hub; level > 0 && res.lower < res.upper; level--) {
+        int best = res.lower;
+        while (pos >= 0 && level_dist[pos] == level) {
+            if (res.n_bfs >= max_bfs) {
+                res.lower = best;
+                res.exact = false;
+                return res;
+            }
+            best = std::max(best, bfs_eccentricity(g, level_nodes[pos], scratch, farthest, visited));
+            res.n_bfs++;
+            pos--;
+        }
+
+        res.lower = best;
+        if (res.lower > 2 * (level - 1)) {
+            break;
+        }
+        res.upper = std::min(res.upper, 2 * (level - 1));
+    }
+
+    res.upper = res.lower;
+    return res;
+}
+
+//' Per-Component Diameter
+//'
+//' Computes the diameter of every connected component in one parallel pass,
+//' using component labels as produced by find_components_cpp. Each component
+//' gets a double-sweep lower bound followed by iFUB, which is exact unless
+//' the per-component BFS budget is exhausted.
+//'
+//' @param edges IntegerMatrix with two columns (from, to)
+//' @param components Component label (1..K) for every node
+//' @param n_nodes Number of nodes in the graph
+//' @param max_bfs Maximum BFS runs per component before falling back to bounds
+//' @param n_threads Number of threads; <= 0 uses all available
+//' @return List with per-component size, diameter (lower bound), upper_bound,
+//'   exact flag and number of BFS runs
+// [[Rcpp::export]]
+Rcpp::List component_diameters_cpp(const Rcpp::IntegerMatrix& edges, const Rcpp::IntegerVector& components,
+                                   int n_nodes, int max_bfs = 1000, int n_threads = 0) {
+    if (components.size() != n_nodes) {
+        Rcpp::stop("components must have one label per node");
+    }
+
+    int n_components = 0;
+    for (int i = 0; i < n_nodes; i++) {
+        if (components[i] == NA_INTEGER || components[i] < 1) {
+            Rcpp::stop("component labels must be positive integers (use compress = TRUE)");
+        }
+        n_components = std::max(n_components, static_cast<int>(components[i]));
+    }
+
+    const int* from = edges.begin();
+    const int* to = from + edges.nrow();
+    CSRGraph g = build_csr(from, to, edges.nrow(), n_nodes);
+
+    // Group nodes by component (counting sort)
+    std::vector<int> comp_offsets(static_cast<size_t>(n_components) + 1, 0);
+    for (int i = 0; i < n_nodes; i++) comp_offsets[components[i]]++;
+    for (int c = 0; c < n_components; c++) comp_offsets[c + 1] += comp_offsets[c];
+    std::vector<int> comp_nodes(n_nodes);
+    std::vector<int> cursor(comp_offsets.begin(), comp_offsets.end() - 1);
+    for (int i = 0; i < n_nodes; i++) comp_nodes[cursor[components[i] - 1]++] = i;
+
+    // Largest components first so the dynamic schedule balances well
+    std::vector<int> order(n_components);
+    for (int c = 0; c < n_components; c++) order[c] = c;
+    std::sort(order.begin(), order.end(), [&comp_offsets](int a, int b) {
+        return comp_offsets[a + 1] - comp_offsets[a] > comp_offsets[b + 1] - comp_offsets[b];
+    });
+
+    std::vector<DiameterResult> results(n_components);
+    n_threads = resolve_threads(n_threads);
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(n_threads)
+#endif
+    {
+        EccentricityScratch scratch(n_nodes);
+
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1)
+#endif
+        for (int k = 0; k < n_components; k++) {
+            int c = order[k];
+            int size = comp_offsets[c + 1] - comp_offsets[c];
+            results[c] = component_diameter(g, comp_nodes.data() + comp_offsets[c], size,
+                                            max_bfs, scratch);
+        }
+    }
+
+    Rcpp::IntegerVector sizes(n_components), diameter(n_components), upper(n_components), n_bfs(n_components);
+    Rcpp::LogicalVector exact(n_components);
+    for (int c = 0; c < n_components; c++) {
+        sizes[c] = comp_offsets[c + 1] - comp_offsets[c];
+        diameter[c] = results[c].lower;
+        upper[c] = results[c].upper;
+        exact[c] = results[c].exact;
+        n_bfs[c] = results[c].n_bfs;
+    }
+
+    return Rcpp::List::create(
+        Rcpp::Named("component") = Rcpp::seq_len(n_components),
+        Rcpp::Named("size") = sizes,
+        Rcpp::Named("diameter") = diameter,
+        Rcpp::Named("upper_bound") = upper,
+        Rcpp::Named("exact") = exact,
+        Rcpp::Named("n_bfs") = n_bfs
+    );
+}
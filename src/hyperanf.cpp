@@ -0,0 +1,212 @@
+#include <Rcpp.h>
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include "parallel_utils.h"
+
+// HyperANF (Boldi, Rosa & Vigna, 2011): every node keeps a HyperLogLog
+// counter of the nodes within t hops. One scan over the edge matrix turns
+// the t-hop counters into (t+1)-hop counters by register-wise max, so the
+// neighborhood function is estimated with a handful of sequential scans.
+
+static inline uint64_t splitmix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+static double hll_alpha(int m) {
+    if (m == 16) return 0.673;
+    if (m == 32) return 0.697;
+    if (m == 64) return 0.709;
+    return 0.7213 / (1.0 + 1.079 / m);
+}
+
+// Cardinality estimate of one counter, with linear counting for small sets
+static double hll_estimate(const uint8_t* reg, int m, double alpha) {
+    double sum = 0.0;
+    int zeros = 0;
+    for (int j = 0; j < m; j++) {
+        sum += std::ldexp(1.0, -reg[j]);
+        if (reg[j] == 0) zeros++;
+    }
+    double estimate = alpha * m * m / sum;
+    if (estimate <= 2.5 * m && zeros > 0) {
+        estimate = m * std::log(static_cast<double>(m) / zeros);
+    }
+    return estimate;
+}
+
+// Merge src into dst register-wise; other threads may be merging into dst
+// concurrently, so each increase is a byte-wide compare-and-swap.
+static inline bool hll_merge(uint8_t* dst, const uint8_t* src, int m) {
+    bool changed = false;
+    for (int j = 0; j < m; j++) {
+        uint8_t value = src[j];
+        uint8_t current = __atomic_load_n(&dst[j], __ATOMIC_RELAXED);
+        while (value > current) {
+            if (__atomic_compare_exchange_n(&dst[j], &current, value, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                changed = true;
+                break;
+            }
+        }
+    }
+    return changed;
+}
+
+struct HyperAnfResult {
+    std::vector<double> neighborhood;  // estimated pairs within t hops, t = 0, 1, ...
+    std::vector<double> harmonic;
+    std::vector<double> reachable;
+    int iterations;
+    bool converged;
+};
+
+static void hyperanf_run(const int* from, const int* to, int64_t n_edges, int n_nodes,
+                         int log2m, int max_iter, int seed, int n_threads, HyperAnfResult& out) {
+    const int m = 1 << log2m;
+    const double alpha = hll_alpha(m);
+    const size_t n_registers = static_cast<size_t>(n_nodes) * m;
+
+    std::vector<uint8_t> current(n_registers, 0);
+    std::vector<uint8_t> next(n_registers, 0);
+    std::vector<uint8_t> changed(n_nodes, 1);
+    std::vector<uint8_t> next_changed(n_nodes, 0);
+
+    // t = 0: each counter holds only its own node
+    for (int v = 0; v < n_nodes; v++) {
+        uint64_t h = splitmix64(static_cast<uint64_t>(v) ^ (static_cast<uint64_t>(seed) << 32));
+        int bucket = static_cast<int>(h >> (64 - log2m));
+        uint64_t rest = h << log2m;
+        int rank = rest == 0 ? 64 - log2m + 1 : __builtin_clzll(rest) + 1;
+        if (rank > 64 - log2m + 1) rank = 64 - log2m + 1;
+        current[static_cast<size_t>(v) * m + bucket] = static_cast<uint8_t>(rank);
+    }
+
+    std::vector<double>& previous_estimate = out.reachable;
+    std::vector<double>& harmonic = out.harmonic;
+    previous_estimate.assign(n_nodes, 1.0);
+    harmonic.assign(n_nodes, 0.0);
+    std::vector<double>& neighborhood = out.neighborhood;
+    neighborhood.clear();
+    neighborhood.push_back(static_cast<double>(n_nodes));
+
+    int& iterations = out.iterations;
+    bool& converged = out.converged;
+    iterations = 0;
+    converged = false;
+
+    while (iterations < max_iter) {
+        std::memcpy(next.data(), current.data(), n_registers);
+        std::fill(next_changed.begin(), next_changed.end(), 0);
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(n_threads) schedule(static)
+#endif
+        for (int64_t i = 0; i < n_edges; i++) {
+            if (from[i] == NA_INTEGER || to[i] == NA_INTEGER) continue;
+            int u = from[i] - 1;
+            int v = to[i] - 1;
+            if (u < 0 || u >= n_nodes || v < 0 || v >= n_nodes || u == v) continue;
+
+            // A counter that did not change last round was already merged
+            // into its neighbors
+            if (changed[v] && hll_merge(&next[static_cast<size_t>(u) * m], &current[static_cast<size_t>(v) * m], m)) {
+                __atomic_store_n(&next_changed[u], 1, __ATOMIC_RELAXED);
+            }
+            if (changed[u] && hll_merge(&next[static_cast<size_t>(v) * m], &current[static_cast<size_t>(u) * m], m)) {
+                __atomic_store_n(&next_changed[v], 1, __ATOMIC_RELAXED);
+            }
+        }
+
+        iterations++;
+        const double t = iterations;
+        double total = 0.0;
+        int64_t n_changed = 0;
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(n_threads) schedule(static) reduction(+:total,n_changed)
+#endif
+        for (int v = 0; v < n_nodes; v++) {
+            double estimate = previous_estimate[v];
+            if (next_changed[v]) {
+                n_changed++;
+                estimate = hll_estimate(&next[static_cast<size_t>(v) * m], m, alpha);
+                if (estimate > previous_estimate[v]) {
+                    harmonic[v] += (estimate - previous_estimate[v]) / t;
+                } else {
+                    estimate = previous_estimate[v];
+                }
+                previous_estimate[v] = estimate;
+            }
+            total += estimate;
+        }
+
+        current.swap(next);
+        changed.swap(next_changed);
+
+        if (n_changed == 0) {
+            converged = true;
+            iterations--;
+            break;
+        }
+        neighborhood.push_back(total);
+
+        Rcpp::checkUserInterrupt();
+    }
+}
+
+//' HyperANF Approximate Neighborhood Function
+//'
+//' Estimates, for t = 0, 1, 2, ..., the number of node pairs within t hops,
+//' plus each node's harmonic centrality, using one HyperLogLog counter per
+//' node. Each iteration is one parallel scan over the edge matrix. Memory is
+//' 2 * n_nodes * 2^log2m bytes.
+//'
+//' @param edges IntegerMatrix with two columns (from, to)
+//' @param n_nodes Number of nodes in the graph
+//' @param log2m log2 of the number of registers per counter (4 to 16)
+//' @param max_iter Maximum number of hops to expand
+//' @param seed Hash seed
+//' @param n_threads Number of threads; <= 0 uses all available
+//' @return List with neighborhood_function, harmonic_centrality, reachable and iterations
+// [[Rcpp::export]]
+Rcpp::List hyperanf_cpp(const Rcpp::IntegerMatrix& edges, int n_nodes, int log2m = 6,
+                        int max_iter = 100, int seed = 42, int n_threads = 0) {
+    if (log2m < 4 || log2m > 16) {
+        Rcpp::stop("log2m must be between 4 and 16");
+    }
+
+    HyperAnfResult out;
+    hyperanf_run(edges.begin(), edges.begin() + edges.nrow(), edges.nrow(), n_nodes,
+                 log2m, max_iter, seed, resolve_threads(n_threads), out);
+    const std::vector<double>& neighborhood = out.neighborhood;
+
+    // Effective diameter: interpolated hop count covering 90% of reachable pairs
+    double effective_diameter = 0.0;
+    double target = 0.9 * neighborhood.back();
+    for (size_t h = 0; h < neighborhood.size(); h++) {
+        if (neighborhood[h] >= target) {
+            if (h == 0) {
+                effective_diameter = 0.0;
+            } else {
+                double gap = neighborhood[h] - neighborhood[h - 1];
+                effective_diameter = (h - 1) + (gap > 0 ? (target - neighborhood[h - 1]) / gap : 1.0);
+            }
+            break;
+        }
+    }
+
+    return Rcpp::List::create(
+        Rcpp::Named("neighborhood_function") = neighborhood,
+        Rcpp::Named("effective_diameter") = effective_diameter,
+        Rcpp::Named("harmonic_centrality") = out.harmonic,
+        Rcpp::Named("reachable") = out.reachable,
+        Rcpp::Named("iterations") = out.iterations,
+        Rcpp::Named("converged") = out.converged,
+        Rcpp::Named("registers") = 1 << log2m
+    );
+}
@@ -0,0 +1,162 @@
+#include <Rcpp.h>
+#include <vector>
+#include <cstdint>
+#include "graph_csr.h"
+#include "parallel_utils.h"
+
+// Per-thread BFS scratch. `stamp` holds the epoch of the last seed that
+// visited each node, so nothing has to be cleared between seeds.
+struct EgoScratch {
+    std::vector<int> stamp;
+    std::vector<int> queue;
+    std::vector<int> hops;
+    int epoch;
+
+    explicit EgoScratch(int n_nodes) : stamp(n_nodes, 0), queue(n_nodes), hops(n_nodes, 0), epoch(0) {}
+};
+
+struct EgoResult {
+    std::vector<int> nodes;  // 0-based, in BFS order (seed first)
+    std::vector<int> hops;
+    std::vector<int> edge_from;
+    std::vector<int> edge_to;
+};
+
+static void k_hop_ball(const CSRGraph& g, int seed, int k, bool induced_edges,
+                       EgoScratch& scratch, EgoResult& out) {
+    const int epoch = ++scratch.epoch;
+    int head = 0, tail = 0;
+
+    scratch.queue[tail++] = seed;
+    scratch.stamp[seed] = epoch;
+    scratch.hops[seed] = 0;
+
+    while (head < tail) {
+        int u = scratch.queue[head++];
+        int hu = scratch.hops[u];
+        if (hu >= k) continue;
+
+        for (int64_t e = g.begin(u); e < g.end(u); e++) {
+            int v = g.targets[e];
+            if (scratch.stamp[v] != epoch) {
+                scratch.stamp[v] = epoch;
+                scratch.hops[v] = hu + 1;
+                scratch.queue[tail++] = v;
+            }
+        }
+    }
+
+    out.nodes.assign(scratch.queue.begin(), scratch.queue.begin() + tail);
+    out.hops.resize(tail);
+    for (int i = 0; i < tail; i++) {
+        out.hops[i] = scratch.hops[out.nodes[i]];
+    }
+
+    if (induced_edges) {
+        // Each undirected edge is stored twice in the CSR; keep the u < v copy
+        for (int i = 0; i < tail; i++) {
+            int u = out.nodes[i];
+            for (int64_t e = g.begin(u); e < g.end(u); e++) {
+                int v = g.targets[e];
+                if (u < v && scratch.stamp[v] == epoch) {
+                    out.edge_from.push_back(u);
+                    out.edge_to.push_back(v);
+                }
+            }
+        }
+    }
+}
+
+//' Batched k-Hop Neighborhoods
+//'
+//' Extracts the set of nodes within k hops of each seed node, optionally
+//' with the edges induced on that set. Seeds are processed in parallel;
+//' each thread reuses an epoch-stamped visited array.
+//'
+//' @param edges IntegerMatrix with two columns (from, to)
+//' @param seeds Seed node IDs (1-based)
+//' @param n_nodes Number of nodes in the graph
+//' @param k Maximum number of hops
+//' @param induced_edges Whether to return the induced edges of each neighborhood
+//' @param n_threads Number of threads; <= 0 uses all available
+//' @return List with flat offsets/values vectors (offsets are 0-based, length n_seeds + 1)
+// [[Rcpp::export]]
+Rcpp::List k_hop_neighborhoods_cpp(const Rcpp::IntegerMatrix& edges, const Rcpp::IntegerVector& seeds,
+                                   int n_nodes, int k, bool induced_edges = false,
+                                   int n_threads = 0) {
+    const int* from = edges.begin();
+    const int* to = from + edges.nrow();
+    CSRGraph g = build_csr(from, to, edges.nrow(), n_nodes);
+
+    const int n_seeds = seeds.size();
+    const int* seed_ptr = seeds.begin();
+    n_threads = resolve_threads(n_threads);
+
+    std::vector<EgoResult> results(n_seeds);
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(n_threads)
+#endif
+    {
+        EgoScratch scratch(n_nodes);
+
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 16)
+#endif
+        for (int i = 0; i < n_seeds; i++) {
+            if (seed_ptr[i] == NA_INTEGER) continue;
+            int seed = seed_ptr[i] - 1;
+            if (seed >= 0 && seed < n_nodes) {
+                k_hop_ball(g, seed, k, induced_edges, scratch, results[i]);
+            }
+        }
+    }
+
+    // Flatten into offsets + values
+    Rcpp::NumericVector offsets(n_seeds + 1);
+    Rcpp::NumericVector edge_offsets(induced_edges ? n_seeds + 1 : 0);
+    double total_nodes = 0, total_edges = 0;
+    for (int i = 0; i < n_seeds; i++) {
+        total_nodes += results[i].nodes.size();
+        offsets[i + 1] = total_nodes;
+        if (induced_edges) {
+            total_edges += results[i].edge_from.size();
+            edge_offsets[i + 1] = total_edges;
+        }
+    }
+
+    Rcpp::IntegerVector nodes(static_cast<R_xlen_t>(total_nodes));
+    Rcpp::IntegerVector hops(static_cast<R_xlen_t>(total_nodes));
+    Rcpp::IntegerVector edge_from(static_cast<R_xlen_t>(total_edges));
+    Rcpp::IntegerVector edge_to(static_cast<R_xlen_t>(total_edges));
+
+    R_xlen_t pos = 0, edge_pos = 0;
+    for (int i = 0; i < n_seeds; i++) {
+        EgoResult& r = results[i];
+        for (size_t j = 0; j < r.nodes.size(); j++, pos++) {
+            nodes[pos] = r.nodes[j] + 1;
+            hops[pos] = r.hops[j];
+        }
+        for (size_t j = 0; j < r.edge_from.size(); j++, edge_pos++) {
+            edge_from[edge_pos] = r.edge_from[j] + 1;
+            edge_to[edge_pos] = r.edge_to[j] + 1;
+        }
+    }
+
+    if (induced_edges) {
+        return Rcpp::List::create(
+            Rcpp::Named("offsets") = offsets,
+            Rcpp::Named("nodes") = nodes,
+            Rcpp::Named("hops") = hops,
+            Rcpp::Named("edge_offsets") = edge_offsets,
+            Rcpp::Named("edge_from") = edge_from,
+            Rcpp::Named("edge_to") = edge_to
+        );
+    }
+
+    return Rcpp::List::create(
+        Rcpp::Named("offsets") = offsets,
+        Rcpp::Named("nodes") = nodes,
+        Rcpp::Named("hops") = hops
+    );
+}
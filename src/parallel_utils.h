@@ -0,0 +1,30 @@
+#ifndef GRAPHFAST_PARALLEL_UTILS_H
+#define GRAPHFAST_PARALLEL_UTILS_H
+
+// OpenMP is optional: without it every kernel runs on the calling thread.
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Resolve a user supplied thread count: <= 0 means "all available".
+inline int resolve_threads(int n_threads) {
+#ifdef _OPENMP
+    if (n_threads <= 0) {
+        return omp_get_max_threads();
+    }
+    return n_threads;
+#else
+    (void)n_threads;
+    return 1;
+#endif
+}
+
+inline int current_thread() {
+#ifdef _OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+
+#endif
@@ -0,0 +1,190 @@
+#include <Rcpp.h>
+#include <vector>
+#include <algorithm>
+#include "approx_matcher.h"
+#include "pattern_matcher.h"
+#include "parallel_utils.h"
+
+// Marks the matrix column of every pattern found in the current string
+struct MarkApprox {
+    int* row;
+    R_xlen_t stride;
+
+    bool operator()(int pattern) {
+        row[pattern * stride] = TRUE;
+        return true;
+    }
+};
+
+//' Approximate Multi-Pattern String Matching
+//'
+//' A pattern matches a string if some substring of it is within max_distance
+//' edits (byte insertions, deletions and substitutions) of the pattern; this
+//' is agrepl(pattern, x, max.distance = k, fixed = TRUE, useBytes = TRUE)
+//' for every pattern at once. Each pattern is cut into max_distance + 1
+//' pieces, of which one must occur exactly; all pieces are found in one
+//' Aho-Corasick pass and only the text around a piece hit is verified with
+//' Myers' bit-parallel edit distance.
+//'
+//' @param strings Character vector of strings to search in
+//' @param patterns Character vector of fixed patterns
+//' @param max_distance Maximum number of edits
+//' @param match_any Logical. Return one value per string instead of a matrix
+//' @param ignore_case Logical. Whether to ignore (ASCII) case. Default FALSE.
+//' @param n_threads Number of threads; <= 0 uses all available
+//'
+//' @return With match_any: logical vector, TRUE where any pattern matches.
+//'   Otherwise a strings x patterns logical matrix.
+//'
+// [[Rcpp::export]]
+SEXP multi_grepl_approx_cpp(const Rcpp::CharacterVector& strings,
+                            const Rcpp::CharacterVector& patterns,
+                            int max_distance,
+                            bool match_any = true,
+                            bool ignore_case = false,
+                            int n_threads = 0) {
+    if (max_distance < 0) {
+        Rcpp::stop("max_distance must be non-negative");
+    }
+    const ApproxMatcher matcher(pattern_strings(patterns), max_distance, ignore_case);
+
+    if (match_any) {
+        // Repeated strings are matched once (see StringRefs)
+        const StringRefs refs(strings, true);
+        const R_xlen_t n_match = refs.size();
+        Rcpp::LogicalVector result(refs.n_elements);
+        std::vector<int> distinct_hits(refs.deduplicated() ? n_match : 0);
+        int* hits = refs.deduplicated() ? distinct_hits.data() : LOGICAL(result);
+        n_threads = matching_threads(n_threads, n_match);
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(n_threads)
+#endif
+        {
+            ApproxMatcher::Scratch scratch;
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1024)
+#endif
+            for (R_xlen_t i = 0; i < n_match; i++) {
+                hits[i] = matcher.any(refs.data[i], refs.length[i], scratch);
+            }
+        }
+
+        if (refs.deduplicated()) {
+            int* out = LOGICAL(result);
+            for (R_xlen_t i = 0; i < refs.n_elements; i++) out[i] = hits[refs.index[i]];
+        }
+        return result;
+    }
+
+    const StringRefs refs(strings);
+    const R_xlen_t n_strings = refs.size();
+    n_threads = matching_threads(n_threads, n_strings);
+
+    Rcpp::LogicalMatrix result(n_strings, matcher.n_patterns());
+    std::fill(result.begin(), result.end(), FALSE);
+    int* out = LOGICAL(result);
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(n_threads)
+#endif
+    {
+        ApproxMatcher::Scratch scratch;
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1024)
+#endif
+        for (R_xlen_t i = 0; i < n_strings; i++) {
+            MarkApprox mark = { out + i, n_strings };
+            matcher.scan(refs.data[i], refs.length[i], scratch, mark);
+        }
+    }
+
+    return result;
+}
+
+// Collects the patterns found in the current string
+struct CollectApprox {
+    std::vector<int>* found;
+
+    bool operator()(int pattern) {
+        found->push_back(pattern);
+        return true;
+    }
+};
+
+//' Approximate Multi-Pattern Matches as Sparse Pairs
+//'
+//' Same information as multi_grepl_approx_cpp(match_any = FALSE) without the
+//' dense matrix: only the (string, pattern) pairs within max_distance edits
+//' are returned.
+//'
+//' @param strings Character vector of strings to search in
+//' @param patterns Character vector of fixed patterns
+//' @param max_distance Maximum number of edits
+//' @param ignore_case Logical. Whether to ignore (ASCII) case. Default FALSE.
+//' @param n_threads Number of threads; <= 0 uses all available
+//'
+//' @return List with integer vectors string and pattern (1-based), ordered by
+//'   string and then pattern, each pair listed once
+//'
+// [[Rcpp::export]]
+Rcpp::List multi_grepl_approx_pairs_cpp(const Rcpp::CharacterVector& strings,
+                                        const Rcpp::CharacterVector& patterns,
+                                        int max_distance,
+                                        bool ignore_case = false,
+                                        int n_threads = 0) {
+    if (max_distance < 0) {
+        Rcpp::stop("max_distance must be non-negative");
+    }
+    const ApproxMatcher matcher(pattern_strings(patterns), max_distance, ignore_case);
+    const StringRefs refs(strings);
+    const R_xlen_t n_strings = refs.size();
+    n_threads = matching_threads(n_threads, n_strings);
+
+    // Blocks of strings are matched independently into their own buffers
+    // and concatenated in block order
+    const R_xlen_t BLOCK = 4096;
+    const R_xlen_t n_blocks = (n_strings + BLOCK - 1) / BLOCK;
+    std::vector<std::vector<int>> block_strings(n_blocks), block_patterns(n_blocks);
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(n_threads)
+#endif
+    {
+        ApproxMatcher::Scratch scratch;
+        std::vector<int> found;
+        CollectApprox collect = { &found };
+
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1)
+#endif
+        for (R_xlen_t b = 0; b < n_blocks; b++) {
+            const R_xlen_t end = std::min(n_strings, (b + 1) * BLOCK);
+            for (R_xlen_t i = b * BLOCK; i < end; i++) {
+                found.clear();
+                matcher.scan(refs.data[i], refs.length[i], scratch, collect);
+                std::sort(found.begin(), found.end());
+                for (size_t k = 0; k < found.size(); k++) {
+                    block_strings[b].push_back(static_cast<int>(i) + 1);
+                    block_patterns[b].push_back(found[k] + 1);
+                }
+            }
+        }
+    }
+
+    R_xlen_t n_pairs = 0;
+    for (R_xlen_t b = 0; b < n_blocks; b++) n_pairs += block_strings[b].size();
+
+    Rcpp::IntegerVector res_string(n_pairs), res_pattern(n_pairs);
+    R_xlen_t pos = 0;
+    for (R_xlen_t b = 0; b < n_blocks; b++) {
+        std::copy(block_strings[b].begin(), block_strings[b].end(), res_string.begin() + pos);
+        std::copy(block_patterns[b].begin(), block_patterns[b].end(), res_pattern.begin() + pos);
+        pos += block_strings[b].size();
+    }
+
+    return Rcpp::List::create(
+        Rcpp::Named("string") = res_string,
+        Rcpp::Named("pattern") = res_pattern
+    );
+}
@@ -0,0 +1,301 @@
+#include <Rcpp.h>
+#include <vector>
+#include <string>
+#include <map>
+#include <memory>
+#include <cctype>
+#include <cstdint>
+#include "pattern_matcher.h"
+#include "parallel_utils.h"
+
+// Boolean expression over fixed patterns, e.g. "(error or timeout) and not
+// debug", compiled to a postfix program over the pattern indices of one
+// PatternMatcher. Operators: and/&/&&, or/|/||, not/!, parentheses; terms
+// are bare words or single/double quoted strings (backslash escapes).
+struct PatternExpression {
+    enum { OP_NOT = -1, OP_AND = -2, OP_OR = -3 };
+
+    std::vector<std::string> terms;
+    std::vector<int> program;    // >= 0 pushes a term, < 0 is an operator
+    std::unique_ptr<PatternMatcher> matcher;
+
+    // Kleene logic: 0 false, 1 true, 2 unknown (term not seen yet, so it may
+    // still occur later in the string). Without `open`, unseen terms are
+    // false. The stack is caller-provided scratch.
+    int evaluate(const std::vector<uint64_t>& hit, bool open, std::vector<uint8_t>& stack) const {
+        stack.clear();
+        for (size_t k = 0; k < program.size(); k++) {
+            const int op = program[k];
+            if (op >= 0) {
+                const bool seen = (hit[op >> 6] >> (op & 63)) & 1;
+                stack.push_back(seen ? 1 : (open ? 2 : 0));
+            } else if (op == OP_NOT) {
+                uint8_t& a = stack.back();
+                if (a != 2) a = 1 - a;
+            } else {
+                const uint8_t b = stack.back();
+                stack.pop_back();
+                uint8_t& a = stack.back();
+                if (op == OP_AND) {
+                    a = (a == 0 || b == 0) ? 0 : (a == 1 && b == 1) ? 1 : 2;
+                } else {
+                    a = (a == 1 || b == 1) ? 1 : (a == 0 && b == 0) ? 0 : 2;
+                }
+            }
+        }
+        return stack.back();
+    }
+};
+
+// Recursive-descent parser producing PatternExpression::program
+class ExpressionParser {
+public:
+    ExpressionParser(const std::string& source, PatternExpression& out) : src_(source), pos_(0), out_(out) {}
+
+    void parse() {
+        next();
+        parse_or();
+        if (token_ != END) fail("unexpected '" + text_ + "'");
+    }
+
+private:
+    enum Token { END, LPAREN, RPAREN, AND, OR, NOT, TERM };
+
+    const std::string& src_;
+    size_t pos_;
+    size_t token_start_;
+    Token token_;
+    std::string text_;
+    PatternExpression& out_;
+    std::map<std::string, int> term_index_;
+
+    void fail(const std::string& message) {
+        Rcpp::stop("Invalid pattern expression at position %d: %s", static_cast<int>(token_start_) + 1,
+                   message);
+    }
+
+    static std::string lower(const std::string& s) {
+        std::string out(s);
+        for (size_t i = 0; i < out.size(); i++) out[i] = static_cast<char>(std::tolower(static_cast<unsigned char>(out[i])));
+        return out;
+    }
+
+    void next() {
+        while (pos_ < src_.size() && std::isspace(static_cast<unsigned char>(src_[pos_]))) pos_++;
+        token_start_ = pos_;
+        text_.clear();
+        if (pos_ >= src_.size()) {
+            token_ = END;
+            return;
+        }
+
+        const char c = src_[pos_];
+        if (c == '(' || c == ')') {
+            token_ = c == '(' ? LPAREN : RPAREN;
+            text_ = c;
+            pos_++;
+            return;
+        }
+        if (c == '&' || c == '|') {
+            token_ = c == '&' ? AND : OR;
+            text_ = c;
+            pos_ += (pos_ + 1 < src_.size() && src_[pos_ + 1] == c) ? 2 : 1;
+            return;
+        }
+        if (c == '!') {
+            token_ = NOT;
+            text_ = c;
+            pos_++;
+            return;
+        }
+        if (c == '"' || c == '\'') {
+            pos_++;
+            while (pos_ < src_.size() && src_[pos_] != c) {
+                if (src_[pos_] == '\\' && pos_ + 1 < src_.size()) pos_++;
+                text_ += src_[pos_++];
+            }
+            if (pos_ >= src_.size()) fail("unterminated quoted pattern");
+            pos_++;
+            token_ = TERM;
+            return;
+        }
+
+        while (pos_ < src_.size() && !std::isspace(static_cast<unsigned char>(src_[pos_])) &&
+               std::string("()&|!\"'").find(src_[pos_]) == std::string::npos) {
+            text_ += src_[pos_++];
+        }
+        const std::string word = lower(text_);
+        token_ = word == "and" ? AND : word == "or" ? OR : word == "not" ? NOT : TERM;
+    }
+
+    void parse_or() {
+        parse_and();
+        while (token_ == OR) {
+            next();
+            parse_and();
+            out_.program.push_back(PatternExpression::OP_OR);
+        }
+    }
+
+    void parse_and() {
+        parse_not();
+        while (token_ == AND) {
+            next();
+            parse_not();
+            out_.program.push_back(PatternExpression::OP_AND);
+        }
+    }
+
+    void parse_not() {
+        if (token_ == NOT) {
+            next();
+            parse_not();
+            out_.program.push_back(PatternExpression::OP_NOT);
+            return;
+        }
+        if (token_ == LPAREN) {
+            next();
+            parse_or();
+            if (token_ != RPAREN) fail("missing ')'");
+            next();
+            return;
+        }
+        if (token_ != TERM) fail(token_ == END ? "expected a pattern" : "unexpected '" + text_ + "'");
+
+        std::map<std::string, int>::const_iterator it = term_index_.find(text_);
+        int index;
+        if (it == term_index_.end()) {
+            index = static_cast<int>(out_.terms.size());
+            term_index_[text_] = index;
+            out_.terms.push_back(text_);
+        } else {
+            index = it->second;
+        }
+        out_.program.push_back(index);
+        next();
+    }
+};
+
+// Records hits in the bitmask and stops once the expression is decided
+struct ExpressionScan {
+    const PatternExpression* expr;
+    std::vector<uint64_t>* hit;
+    std::vector<uint8_t>* stack;
+    int result;
+
+    bool operator()(int pattern, size_t) {
+        uint64_t& word = (*hit)[pattern >> 6];
+        const uint64_t bit = uint64_t(1) << (pattern & 63);
+        if (word & bit) return true;
+        word |= bit;
+        result = expr->evaluate(*hit, true, *stack);
+        return result == 2;
+    }
+};
+
+static PatternExpression* get_pattern_expression(SEXP ptr) {
+    Rcpp::XPtr<PatternExpression> xp(ptr);
+    if (xp.get() == nullptr) {
+        Rcpp::stop("Compiled pattern expression is no longer valid (external pointers do not "
+                   "survive saveRDS or a new session). Call compile_expression() again.");
+    }
+    return xp.get();
+}
+
+static PatternExpression* parse_expression(const std::string& source, bool ignore_case) {
+    std::unique_ptr<PatternExpression> expr(new PatternExpression());
+    ExpressionParser(source, *expr).parse();
+    expr->matcher.reset(new PatternMatcher(expr->terms, ignore_case));
+    return expr.release();
+}
+
+//' Compile a Boolean Pattern Expression
+//'
+//' @param expr Expression string, e.g. "(error or timeout) and not debug"
+//' @param ignore_case Whether matching ignores case
+//' @return List with the external pointer, the distinct patterns (terms) in
+//'   order of first appearance, and the postfix program (term indices are
+//'   0-based, -1 not, -2 and, -3 or)
+// [[Rcpp::export]]
+Rcpp::List compile_expression_cpp(std::string expr, bool ignore_case = false) {
+    PatternExpression* compiled = parse_expression(expr, ignore_case);
+    Rcpp::XPtr<PatternExpression> ptr(compiled, true);
+
+    return Rcpp::List::create(
+        Rcpp::Named("ptr") = ptr,
+        Rcpp::Named("patterns") = compiled->terms,
+        Rcpp::Named("program") = Rcpp::IntegerVector(compiled->program.begin(), compiled->program.end())
+    );
+}
+
+//' Match Strings Against a Boolean Pattern Expression
+//'
+//' One automaton pass per string records which patterns occur in a bitmask.
+//' After every newly seen pattern the expression is evaluated in three-valued
+//' logic (patterns not seen yet are unknown), and the scan stops as soon as
+//' the result no longer depends on the rest of the string; otherwise unseen
+//' patterns count as absent at the end.
+//'
+//' @param strings Character vector of strings to search in
+//' @param expr Expression string, or the external pointer of a compiled
+//'   expression
+//' @param ignore_case Logical. Whether to ignore case (expression strings
+//'   only). Default FALSE.
+//' @param n_threads Number of threads; <= 0 uses all available
+//'
+//' @return Logical vector, TRUE where the expression holds
+//'
+// [[Rcpp::export]]
+Rcpp::LogicalVector match_expression_cpp(const Rcpp::CharacterVector& strings,
+                                         SEXP expr,
+                                         bool ignore_case = false,
+                                         int n_threads = 0) {
+    std::unique_ptr<PatternExpression> owned;
+    const PatternExpression* compiled;
+    if (TYPEOF(expr) == EXTPTRSXP) {
+        compiled = get_pattern_expression(expr);
+    } else {
+        if (TYPEOF(expr) != STRSXP || Rf_length(expr) != 1) {
+            Rcpp::stop("expr must be a single string or a compiled expression");
+        }
+        owned.reset(parse_expression(Rcpp::as<std::string>(expr), ignore_case));
+        compiled = owned.get();
+    }
+    const PatternMatcher& matcher = *compiled->matcher;
+    const size_t n_words = (static_cast<size_t>(matcher.n_patterns()) + 63) / 64;
+
+    // Repeated strings are matched once (see StringRefs)
+    const StringRefs refs(strings, true);
+    const R_xlen_t n_match = refs.size();
+    Rcpp::LogicalVector result(refs.n_elements);
+    std::vector<int> distinct_hits(refs.deduplicated() ? n_match : 0);
+    int* hits = refs.deduplicated() ? distinct_hits.data() : LOGICAL(result);
+    n_threads = matching_threads(n_threads, n_match);
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(n_threads)
+#endif
+    {
+        std::vector<uint64_t> hit(n_words);
+        std::vector<uint8_t> stack;
+        stack.reserve(compiled->program.size());
+        ExpressionScan scan = { compiled, &hit, &stack, 2 };
+
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1024)
+#endif
+        for (R_xlen_t i = 0; i < n_match; i++) {
+            std::fill(hit.begin(), hit.end(), 0);
+            scan.result = compiled->evaluate(hit, true, stack);
+            if (scan.result == 2) matcher.scan(refs.data[i], refs.length[i], scan);
+            if (scan.result == 2) scan.result = compiled->evaluate(hit, false, stack);
+            hits[i] = scan.result;
+        }
+    }
+
+    if (refs.deduplicated()) {
+        int* out = LOGICAL(result);
+        for (R_xlen_t i = 0; i < refs.n_elements; i++) out[i] = hits[refs.index[i]];
+    }
+    return result;
+}
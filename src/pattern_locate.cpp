@@ -0,0 +1,141 @@
+#include <Rcpp.h>
+#include <vector>
+#include <algorithm>
+#include <memory>
+#include "pattern_matcher.h"
+#include "parallel_utils.h"
+
+// Converts byte spans to character spans of a UTF-8 string by counting
+// lead bytes; `spans` must be in text order
+static void to_char_offsets(const char* text, std::vector<PatternMatch>& spans) {
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(text);
+    size_t byte = 0, chars = 0;
+    for (size_t k = 0; k < spans.size(); k++) {
+        for (; byte < spans[k].start; byte++) chars += (p[byte] & 0xC0) != 0x80;
+        const size_t start_chars = chars;
+        for (; byte < spans[k].start + spans[k].length; byte++) chars += (p[byte] & 0xC0) != 0x80;
+        spans[k].start = start_chars;
+        spans[k].length = chars - start_chars;
+    }
+}
+
+//' Locate Fixed Patterns in Strings
+//'
+//' Single-scan counterpart of regexpr()/gregexpr() for a set of fixed
+//' patterns. The first mode reports, per string, the leftmost match (longest
+//' pattern on ties, then lowest index). The all mode reports the
+//' leftmost-longest, non-overlapping matches of every string as flat vectors.
+//'
+//' @param strings Character vector of strings to search in
+//' @param patterns Character vector of fixed patterns to search for, or the
+//'   external pointer of a compiled pattern set
+//' @param all Logical. Report every non-overlapping match instead of the first
+//' @param ignore_case Logical. Whether to ignore case. Default FALSE.
+//' @param use_bytes Logical. Report byte rather than UTF-8 character offsets
+//' @param n_threads Number of threads; <= 0 uses all available
+//'
+//' @return With all = FALSE: list of pattern (1-based, NA if none), start
+//'   (1-based, -1 if none) and length (-1 if none), one entry per string.
+//'   With all = TRUE: list of string, pattern, start and length, one entry per
+//'   match, in string and then text order.
+//'
+// [[Rcpp::export]]
+Rcpp::List locate_patterns_cpp(const Rcpp::CharacterVector& strings,
+                               SEXP patterns,
+                               bool all = false,
+                               bool ignore_case = false,
+                               bool use_bytes = false,
+                               int n_threads = 0) {
+    std::unique_ptr<PatternMatcher> owned;
+    const PatternMatcher& matcher = *resolve_matcher(patterns, ignore_case, owned);
+    const StringRefs refs(strings);
+    const R_xlen_t n_strings = refs.size();
+    n_threads = matching_threads(n_threads, n_strings);
+
+    if (!all) {
+        Rcpp::IntegerVector res_pattern(n_strings), res_start(n_strings), res_length(n_strings);
+        int* out_pattern = res_pattern.begin();
+        int* out_start = res_start.begin();
+        int* out_length = res_length.begin();
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(n_threads)
+#endif
+        {
+            std::vector<PatternMatch> span(1);
+
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1024)
+#endif
+            for (R_xlen_t i = 0; i < n_strings; i++) {
+                if (!matcher.first_match(refs.data[i], refs.length[i], span[0])) {
+                    out_pattern[i] = NA_INTEGER;
+                    out_start[i] = -1;
+                    out_length[i] = -1;
+                    continue;
+                }
+                if (!use_bytes) to_char_offsets(refs.data[i], span);
+                out_pattern[i] = span[0].pattern + 1;
+                out_start[i] = static_cast<int>(span[0].start) + 1;
+                out_length[i] = static_cast<int>(span[0].length);
+            }
+        }
+
+        return Rcpp::List::create(
+            Rcpp::Named("pattern") = res_pattern,
+            Rcpp::Named("start") = res_start,
+            Rcpp::Named("length") = res_length
+        );
+    }
+
+    // Blocks of strings fill their own buffers, concatenated in block order
+    const R_xlen_t BLOCK = 4096;
+    const R_xlen_t n_blocks = (n_strings + BLOCK - 1) / BLOCK;
+    std::vector<std::vector<int>> block_string(n_blocks), block_pattern(n_blocks);
+    std::vector<std::vector<int>> block_start(n_blocks), block_length(n_blocks);
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(n_threads)
+#endif
+    {
+        std::vector<PatternMatch> spans;
+
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1)
+#endif
+        for (R_xlen_t b = 0; b < n_blocks; b++) {
+            const R_xlen_t end = std::min(n_strings, (b + 1) * BLOCK);
+            for (R_xlen_t i = b * BLOCK; i < end; i++) {
+                matcher.all_matches(refs.data[i], refs.length[i], spans);
+                if (!use_bytes) to_char_offsets(refs.data[i], spans);
+                for (size_t k = 0; k < spans.size(); k++) {
+                    block_string[b].push_back(static_cast<int>(i) + 1);
+                    block_pattern[b].push_back(spans[k].pattern + 1);
+                    block_start[b].push_back(static_cast<int>(spans[k].start) + 1);
+                    block_length[b].push_back(static_cast<int>(spans[k].length));
+                }
+            }
+        }
+    }
+
+    R_xlen_t n_matches = 0;
+    for (R_xlen_t b = 0; b < n_blocks; b++) n_matches += block_string[b].size();
+
+    Rcpp::IntegerVector res_string(n_matches), res_pattern(n_matches);
+    Rcpp::IntegerVector res_start(n_matches), res_length(n_matches);
+    R_xlen_t pos = 0;
+    for (R_xlen_t b = 0; b < n_blocks; b++) {
+        std::copy(block_string[b].begin(), block_string[b].end(), res_string.begin() + pos);
+        std::copy(block_pattern[b].begin(), block_pattern[b].end(), res_pattern.begin() + pos);
+        std::copy(block_start[b].begin(), block_start[b].end(), res_start.begin() + pos);
+        std::copy(block_length[b].begin(), block_length[b].end(), res_length.begin() + pos);
+        pos += block_string[b].size();
+    }
+
+    return Rcpp::List::create(
+        Rcpp::Named("string") = res_string,
+        Rcpp::Named("pattern") = res_pattern,
+        Rcpp::Named("start") = res_start,
+        Rcpp::Named("length") = res_length
+    );
+}
@@ -0,0 +1,343 @@
+#ifndef GRAPHFAST_PATTERN_MATCHER_H
+#define GRAPHFAST_PATTERN_MATCHER_H
+
+#include <Rcpp.h>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <memory>
+#include <climits>
+#include "aho_corasick.h"
+#include "simd_search.h"
+#include "utf8_fold.h"
+#include "parallel_utils.h"
+
+// A located occurrence: pattern index and byte span
+struct PatternMatch {
+    int pattern;
+    size_t start;
+    size_t length;
+};
+
+// Fixed-string multi-pattern matcher used by all string kernels.
+//
+// "Does any pattern occur" picks the cheapest scan for the set: one pattern
+// uses the SIMD first/last-byte search; up to Teddy::MAX_PATTERNS patterns use
+// the Teddy literal matcher when the CPU has SSSE3; otherwise small sets are
+// searched one pattern at a time, shortest first, and from
+// AUTOMATON_MIN_PATTERNS patterns on a single Aho-Corasick scan is cheaper.
+// Enumerating every occurrence always uses the automaton.
+//
+// ignore_case folds ASCII letters and, through the compiled automaton, the
+// UTF-8 characters covered by utf8_fold.h. Folding preserves byte lengths
+// and never maps non-ASCII to ASCII, so the SIMD scans (which fold ASCII
+// only) stay exact whenever the text or every pattern is pure ASCII; other
+// strings are scanned by the automaton.
+//
+// Instances are immutable after construction and safe to share between
+// threads.
+class PatternMatcher {
+public:
+    static const int AUTOMATON_MIN_PATTERNS = 8;
+
+    PatternMatcher(const std::vector<std::string>& patterns, bool ignore_case)
+        : ignore_case_(ignore_case) {
+        for (int c = 0; c < 256; c++) {
+            fold_[c] = static_cast<uint8_t>(ignore_case && c >= 'A' && c <= 'Z' ? c + 32 : c);
+        }
+
+        utf8_fold_ = false;
+        patterns_.resize(patterns.size());
+        for (size_t p = 0; p < patterns.size(); p++) {
+            patterns_[p] = patterns[p];
+            if (ignore_case) {
+                fold_utf8(patterns_[p]);
+                if (!simd::is_ascii(patterns_[p].data(), patterns_[p].size())) utf8_fold_ = true;
+            }
+        }
+
+        by_length_.resize(patterns_.size());
+        for (size_t p = 0; p < patterns_.size(); p++) by_length_[p] = static_cast<int>(p);
+        std::stable_sort(by_length_.begin(), by_length_.end(), [this](int a, int b) {
+            return patterns_[a].size() < patterns_[b].size();
+        });
+
+        automaton_.build(patterns_, fold_, utf8_fold_);
+        use_automaton_ = n_patterns() >= AUTOMATON_MIN_PATTERNS;
+        if (n_patterns() > 1) teddy_.build(patterns_, ignore_case);
+    }
+
+    int n_patterns() const { return static_cast<int>(patterns_.size()); }
+    bool ignore_case() const { return ignore_case_; }
+
+    // Scan used by any() on this CPU
+    const char* any_method() const {
+        if (use_teddy()) return "teddy";
+        if (use_automaton_) return "aho-corasick";
+        return "per pattern";
+    }
+
+    const std::string& pattern(int p) const { return patterns_[p]; }
+    const AhoCorasick& automaton() const { return automaton_; }
+
+    // True if any pattern occurs in text[0, len)
+    bool any(const char* text, size_t len) const {
+        if (utf8_fold_ && !simd::is_ascii(text, len)) {
+            return automaton_.contains_any(text, len);
+        }
+        if (use_teddy()) {
+            return teddy_.any(text, len);
+        }
+        if (use_automaton_) {
+            return automaton_.contains_any(text, len);
+        }
+        for (size_t k = 0; k < by_length_.size(); k++) {
+            const std::string& pattern = patterns_[by_length_[k]];
+            if (pattern.size() > len) break;
+            if (pattern.empty() ||
+                simd::find(text, len, pattern.data(), pattern.size(), ignore_case_) != simd::NOT_FOUND) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Calls f(pattern, end) for every occurrence (see AhoCorasick::for_each_match)
+    template <class F>
+    void for_each_match(const char* text, size_t len, F& f) const {
+        automaton_.for_each_match(text, len, f);
+    }
+
+    // As for_each_match, but f returns false to stop the scan
+    template <class F>
+    void scan(const char* text, size_t len, F& f) const {
+        automaton_.scan(text, len, f);
+    }
+
+    // Leftmost-longest occurrence (ties go to the lower pattern index);
+    // false if no pattern occurs
+    bool first_match(const char* text, size_t len, PatternMatch& m) const {
+        FirstMatch f = { this, false, { 0, 0, 0 } };
+        automaton_.scan(text, len, f);
+        m = f.best;
+        return f.found;
+    }
+
+    // Leftmost-longest, non-overlapping occurrences, in text order; empty
+    // patterns are skipped. `out` is cleared first.
+    void all_matches(const char* text, size_t len, std::vector<PatternMatch>& out) const {
+        out.clear();
+        CollectMatches f = { this, &out };
+        automaton_.for_each_match(text, len, f);
+
+        std::sort(out.begin(), out.end(), [](const PatternMatch& a, const PatternMatch& b) {
+            if (a.start != b.start) return a.start < b.start;
+            if (a.length != b.length) return a.length > b.length;
+            return a.pattern < b.pattern;
+        });
+        size_t kept = 0, covered = 0;
+        for (size_t k = 0; k < out.size(); k++) {
+            if (kept > 0 && out[k].start < covered) continue;
+            out[kept++] = out[k];
+            covered = out[k].start + out[k].length;
+        }
+        out.resize(kept);
+    }
+
+    double memory_bytes() const {
+        double bytes = automaton_.memory_bytes() + by_length_.size() * sizeof(int);
+        for (size_t p = 0; p < patterns_.size(); p++) bytes += patterns_[p].capacity();
+        return bytes;
+    }
+
+private:
+    std::vector<std::string> patterns_;  // folded when ignore_case
+    std::vector<int> by_length_;
+    bool ignore_case_;
+    bool utf8_fold_;  // ignore_case with non-ASCII patterns
+    bool use_automaton_;
+    uint8_t fold_[256];
+    AhoCorasick automaton_;
+    simd::Teddy teddy_;
+
+    bool use_teddy() const {
+        return teddy_.ready() && simd::level() >= simd::SSSE3;
+    }
+
+    // Keeps the leftmost-longest match; stops once no match starting at or
+    // before the current best can still end
+    struct FirstMatch {
+        const PatternMatcher* matcher;
+        bool found;
+        PatternMatch best;
+
+        bool operator()(int pattern, size_t end) {
+            const size_t length = matcher->patterns_[pattern].size();
+            const size_t start = end - length;
+            if (found && end > best.start + matcher->automaton_.max_pattern_length()) return false;
+            if (!found || start < best.start ||
+                (start == best.start && (length > best.length ||
+                                         (length == best.length && pattern < best.pattern)))) {
+                best.pattern = pattern;
+                best.start = start;
+                best.length = length;
+                found = true;
+            }
+            return true;
+        }
+    };
+
+    struct CollectMatches {
+        const PatternMatcher* matcher;
+        std::vector<PatternMatch>* out;
+
+        void operator()(int pattern, size_t end) {
+            const size_t length = matcher->patterns_[pattern].size();
+            if (length == 0) return;
+            PatternMatch m = { pattern, end - length, length };
+            out->push_back(m);
+        }
+    };
+};
+
+// UTF-8 bytes of a CHARSXP: latin1-marked strings are translated (in
+// R-managed memory that lives until the .Call returns; ASCII ones come back
+// as CHAR(s)), others are used in place. Main thread only.
+inline const char* utf8_chars(SEXP s, int& length) {
+    if (Rf_getCharCE(s) == CE_LATIN1) {
+        const char* translated = Rf_translateCharUTF8(s);
+        length = static_cast<int>(std::strlen(translated));
+        return translated;
+    }
+    length = LENGTH(s);
+    return CHAR(s);
+}
+
+// Patterns of an R character vector as UTF-8 byte strings (NA becomes "NA",
+// as with CHAR())
+inline std::vector<std::string> pattern_strings(const Rcpp::CharacterVector& patterns) {
+    std::vector<std::string> out(patterns.size());
+    for (R_xlen_t p = 0; p < patterns.size(); p++) {
+        int length;
+        const char* chars = utf8_chars(patterns[p], length);
+        out[p].assign(chars, length);
+    }
+    return out;
+}
+
+// UTF-8 pointers and byte lengths of a character vector, gathered on the
+// main thread so worker threads never call the R API.
+//
+// With dedupe, equal strings are matched once. R interns strings, so equal
+// elements share one CHARSXP and a pointer hash finds repeats without
+// comparing bytes: `data`/`length` then hold the distinct strings and
+// `index` maps every element to one of them. If the first DEDUPE_PROBE
+// elements are mostly distinct, deduplication is abandoned and `index` is
+// left empty.
+struct StringRefs {
+    static const R_xlen_t DEDUPE_PROBE = 65536;
+
+    std::vector<const char*> data;
+    std::vector<int> length;
+    std::vector<int> index;
+    R_xlen_t n_elements;
+
+    explicit StringRefs(const Rcpp::CharacterVector& strings, bool dedupe = false)
+        : n_elements(strings.size()) {
+        std::vector<SEXP> distinct;
+        if (dedupe && n_elements > 1 && n_elements < INT_MAX && find_distinct(strings, distinct)) {
+            data.resize(distinct.size());
+            length.resize(distinct.size());
+            for (size_t k = 0; k < distinct.size(); k++) {
+                data[k] = utf8_chars(distinct[k], length[k]);
+            }
+            return;
+        }
+
+        data.resize(n_elements);
+        length.resize(n_elements);
+        for (R_xlen_t i = 0; i < n_elements; i++) {
+            data[i] = utf8_chars(STRING_ELT(strings, i), length[i]);
+        }
+    }
+
+    // Number of strings to match: distinct ones when deduplicated
+    R_xlen_t size() const { return static_cast<R_xlen_t>(data.size()); }
+    bool deduplicated() const { return !index.empty(); }
+
+private:
+    // Open-addressing pointer hash (linear probing, load <= 1/2)
+    bool find_distinct(const Rcpp::CharacterVector& strings, std::vector<SEXP>& distinct) {
+        size_t capacity = size_t(1) << 12;
+        std::vector<int> table(capacity, -1);
+        index.resize(n_elements);
+
+        for (R_xlen_t i = 0; i < n_elements; i++) {
+            SEXP s = STRING_ELT(strings, i);
+            size_t h = slot(s, capacity);
+            while (table[h] >= 0 && distinct[table[h]] != s) h = (h + 1) & (capacity - 1);
+            if (table[h] < 0) {
+                table[h] = static_cast<int>(distinct.size());
+                distinct.push_back(s);
+                if (distinct.size() * 2 > capacity) {
+                    capacity *= 2;
+                    table.assign(capacity, -1);
+                    for (size_t k = 0; k < distinct.size(); k++) {
+                        size_t g = slot(distinct[k], capacity);
+                        while (table[g] >= 0) g = (g + 1) & (capacity - 1);
+                        table[g] = static_cast<int>(k);
+                    }
+                    h = slot(s, capacity);
+                    while (distinct[table[h]] != s) h = (h + 1) & (capacity - 1);
+                }
+            }
+            index[i] = table[h];
+
+            if (i + 1 == DEDUPE_PROBE && static_cast<R_xlen_t>(distinct.size()) * 2 > DEDUPE_PROBE) {
+                index.clear();
+                distinct.clear();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static size_t slot(SEXP s, size_t capacity) {
+        uint64_t h = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(s) >> 4) * 0x9E3779B97F4A7C15ULL;
+        return static_cast<size_t>(h >> 32) & (capacity - 1);
+    }
+};
+
+// Thread count for matching n strings: small inputs stay on one thread
+inline int matching_threads(int n_threads, R_xlen_t n_strings) {
+    const R_xlen_t PARALLEL_MIN_STRINGS = 4096;
+    return n_strings < PARALLEL_MIN_STRINGS ? 1 : resolve_threads(n_threads);
+}
+
+inline const PatternMatcher* get_pattern_matcher(SEXP ptr) {
+    Rcpp::XPtr<PatternMatcher> xp(ptr);
+    if (xp.get() == nullptr) {
+        Rcpp::stop("Compiled pattern set is no longer valid (external pointers do not survive "
+                   "saveRDS or a new session). Call compile_patterns() again.");
+    }
+    return xp.get();
+}
+
+// Matcher for a `patterns` argument: the external pointer of a compiled
+// pattern set is used as is (with its own ignore_case), a character vector
+// is compiled into `owned` for this call
+inline const PatternMatcher* resolve_matcher(SEXP patterns, bool ignore_case,
+                                             std::unique_ptr<PatternMatcher>& owned) {
+    if (TYPEOF(patterns) == EXTPTRSXP) {
+        return get_pattern_matcher(patterns);
+    }
+    if (TYPEOF(patterns) != STRSXP) {
+        Rcpp::stop("patterns must be a character vector or a compiled pattern set");
+    }
+    owned.reset(new PatternMatcher(pattern_strings(Rcpp::CharacterVector(patterns)), ignore_case));
+    return owned.get();
+}
+
+#endif
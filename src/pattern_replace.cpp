@@ -0,0 +1,138 @@
+#include <Rcpp.h>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <memory>
+#include <climits>
+#include <cstring>
+#include <cstdint>
+#include "pattern_matcher.h"
+#include "parallel_utils.h"
+
+//' Replace Fixed Patterns in One Pass
+//'
+//' Every string is scanned once; the leftmost-longest, non-overlapping
+//' occurrences of all patterns (see all_matches) are replaced by the
+//' replacement of the matching pattern. Rewritten strings are assembled in
+//' per-block byte buffers on the worker threads, so each changed string costs
+//' one CHARSXP allocation on the main thread; unchanged strings (and NA)
+//' keep their original CHARSXP. Repeated strings are rewritten once.
+//'
+//' @param strings Character vector of strings to rewrite
+//' @param patterns Character vector of fixed patterns to search for, or the
+//'   external pointer of a compiled pattern set
+//' @param replacements Character vector, one replacement per pattern
+//' @param ignore_case Logical. Whether to ignore case. Default FALSE.
+//' @param n_threads Number of threads; <= 0 uses all available
+//'
+//' @return Character vector the length of strings (UTF-8 where changed)
+//'
+// [[Rcpp::export]]
+Rcpp::CharacterVector multi_replace_cpp(const Rcpp::CharacterVector& strings,
+                                        SEXP patterns,
+                                        const Rcpp::CharacterVector& replacements,
+                                        bool ignore_case = false,
+                                        int n_threads = 0) {
+    std::unique_ptr<PatternMatcher> owned;
+    const PatternMatcher& matcher = *resolve_matcher(patterns, ignore_case, owned);
+    if (replacements.size() != matcher.n_patterns()) {
+        Rcpp::stop("replacements must have one element per pattern");
+    }
+    const std::vector<std::string> replacement = pattern_strings(replacements);
+
+    const StringRefs refs(strings, true);
+    const R_xlen_t n_match = refs.size();
+    n_threads = matching_threads(n_threads, n_match);
+
+    // Rewritten strings of a block are appended to its buffer; offset -1
+    // marks a string left unchanged
+    const R_xlen_t BLOCK = 4096;
+    const R_xlen_t n_blocks = (n_match + BLOCK - 1) / BLOCK;
+    std::vector<std::string> block_text(n_blocks);
+    std::vector<int64_t> offset(n_match, -1);
+    std::vector<int> length(n_match, 0);
+    int too_long = 0;
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(n_threads)
+#endif
+    {
+        std::vector<PatternMatch> spans;
+
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1)
+#endif
+        for (R_xlen_t b = 0; b < n_blocks; b++) {
+            std::string& buffer = block_text[b];
+            const R_xlen_t end = std::min(n_match, (b + 1) * BLOCK);
+            for (R_xlen_t i = b * BLOCK; i < end; i++) {
+                const char* text = refs.data[i];
+                const size_t len = static_cast<size_t>(refs.length[i]);
+                matcher.all_matches(text, len, spans);
+                if (spans.empty()) continue;
+
+                int64_t out_len = static_cast<int64_t>(len);
+                for (size_t k = 0; k < spans.size(); k++) {
+                    out_len += static_cast<int64_t>(replacement[spans[k].pattern].size()) -
+                               static_cast<int64_t>(spans[k].length);
+                }
+                if (out_len > INT_MAX) {
+#ifdef _OPENMP
+#pragma omp atomic write
+#endif
+                    too_long = 1;
+                    continue;
+                }
+
+                const size_t first = buffer.size();
+                size_t pos = 0;
+                for (size_t k = 0; k < spans.size(); k++) {
+                    buffer.append(text + pos, spans[k].start - pos);
+                    buffer.append(replacement[spans[k].pattern]);
+                    pos = spans[k].start + spans[k].length;
+                }
+                buffer.append(text + pos, len - pos);
+
+                // Replacing a match by identical text leaves the string as is
+                if (out_len == static_cast<int64_t>(len) && std::memcmp(buffer.data() + first, text, len) == 0) {
+                    buffer.resize(first);
+                    continue;
+                }
+                offset[i] = static_cast<int64_t>(first);
+                length[i] = static_cast<int>(out_len);
+            }
+        }
+    }
+
+    if (too_long) {
+        Rcpp::stop("a replaced string would exceed the maximum string length");
+    }
+
+    // CHARSXPs are created here, once per distinct changed string
+    const R_xlen_t n_elements = refs.n_elements;
+    Rcpp::CharacterVector result(n_elements);
+    Rcpp::CharacterVector created(refs.deduplicated() ? n_match : 0);
+    std::vector<uint8_t> is_created(created.size(), 0);
+
+    for (R_xlen_t i = 0; i < n_elements; i++) {
+        const R_xlen_t k = refs.deduplicated() ? refs.index[i] : i;
+        SEXP original = STRING_ELT(strings, i);
+        if (offset[k] < 0 || original == NA_STRING) {
+            SET_STRING_ELT(result, i, original);
+            continue;
+        }
+        if (!refs.deduplicated()) {
+            const std::string& buffer = block_text[k / BLOCK];
+            SET_STRING_ELT(result, i, Rf_mkCharLenCE(buffer.data() + offset[k], length[k], CE_UTF8));
+            continue;
+        }
+        if (!is_created[k]) {
+            const std::string& buffer = block_text[k / BLOCK];
+            SET_STRING_ELT(created, k, Rf_mkCharLenCE(buffer.data() + offset[k], length[k], CE_UTF8));
+            is_created[k] = 1;
+        }
+        SET_STRING_ELT(result, i, STRING_ELT(created, k));
+    }
+
+    return result;
+}
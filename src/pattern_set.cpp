@@ -0,0 +1,39 @@
+#include <Rcpp.h>
+#include <string>
+#include "pattern_matcher.h"
+
+//' Compile a Pattern Set
+//'
+//' Folds, sorts and builds the Aho-Corasick automaton for a set of fixed
+//' patterns once, so repeated matching calls skip that work.
+//'
+//' @param patterns Character vector of fixed patterns
+//' @param ignore_case Whether matching ignores case
+//' @return List with the external pointer, pattern count, ignore_case, the
+//'   scan used for any-match queries, automaton size and memory use
+// [[Rcpp::export]]
+Rcpp::List compile_patterns_cpp(const Rcpp::CharacterVector& patterns, bool ignore_case = false) {
+    PatternMatcher* matcher = new PatternMatcher(pattern_strings(patterns), ignore_case);
+    Rcpp::XPtr<PatternMatcher> ptr(matcher, true);
+
+    return Rcpp::List::create(
+        Rcpp::Named("ptr") = ptr,
+        Rcpp::Named("n_patterns") = matcher->n_patterns(),
+        Rcpp::Named("ignore_case") = ignore_case,
+        Rcpp::Named("method") = std::string(matcher->any_method()),
+        Rcpp::Named("n_states") = matcher->automaton().n_states(),
+        Rcpp::Named("memory_bytes") = matcher->memory_bytes()
+    );
+}
+
+//' SIMD Level Used by the String Kernels
+//'
+//' @param cap If >= 0, caps the instruction set used from now on
+//'   (0 scalar, 1 SSE2, 2 SSSE3, 3 AVX2), e.g. to compare against the scalar
+//'   fallback
+//' @return The level in effect
+// [[Rcpp::export]]
+int simd_level_cpp(int cap = -1) {
+    if (cap >= 0) simd::set_level_cap(cap);
+    return simd::level();
+}
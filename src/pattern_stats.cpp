@@ -0,0 +1,99 @@
+#include <Rcpp.h>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "pattern_matcher.h"
+#include "parallel_utils.h"
+
+// Per-thread tallies: strings containing each pattern and occurrences
+struct HitCounter {
+    std::vector<int64_t>* strings;
+    std::vector<int64_t>* occurrences;
+    std::vector<R_xlen_t>* seen;
+    R_xlen_t current;
+    int64_t weight;  // number of elements sharing the current string
+    bool matched;
+
+    void operator()(int pattern, size_t) {
+        matched = true;
+        (*occurrences)[pattern] += weight;
+        if ((*seen)[pattern] != current) {
+            (*seen)[pattern] = current;
+            (*strings)[pattern] += weight;
+        }
+    }
+};
+
+//' Per-Pattern Hit Counts
+//'
+//' Counts, for every pattern, the strings that contain it and its total
+//' number of occurrences (overlapping occurrences included), from one
+//' automaton pass per distinct string. Threads keep private counters that
+//' are summed at the end.
+//'
+//' @param strings Character vector of strings to search in
+//' @param patterns Character vector of fixed patterns to search for, or the
+//'   external pointer of a compiled pattern set
+//' @param ignore_case Logical. Whether to ignore case. Default FALSE.
+//' @param n_threads Number of threads; <= 0 uses all available
+//'
+//' @return List with numeric vectors strings and occurrences, one entry per
+//'   pattern, and the number of strings matching at least one pattern
+//'
+// [[Rcpp::export]]
+Rcpp::List pattern_hits_cpp(const Rcpp::CharacterVector& strings,
+                            SEXP patterns,
+                            bool ignore_case = false,
+                            int n_threads = 0) {
+    std::unique_ptr<PatternMatcher> owned;
+    const PatternMatcher& matcher = *resolve_matcher(patterns, ignore_case, owned);
+    const StringRefs refs(strings, true);
+    const R_xlen_t n_match = refs.size();
+    const int n_patterns = matcher.n_patterns();
+    n_threads = matching_threads(n_threads, n_match);
+
+    // Repeated strings are scanned once and counted with their multiplicity
+    std::vector<int64_t> weight;
+    if (refs.deduplicated()) {
+        weight.assign(n_match, 0);
+        for (R_xlen_t i = 0; i < refs.n_elements; i++) weight[refs.index[i]]++;
+    }
+
+    std::vector<std::vector<int64_t>> thread_strings(n_threads, std::vector<int64_t>(n_patterns, 0));
+    std::vector<std::vector<int64_t>> thread_occurrences(n_threads, std::vector<int64_t>(n_patterns, 0));
+    int64_t n_matched = 0;
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(n_threads) reduction(+:n_matched)
+#endif
+    {
+        const int t = current_thread();
+        std::vector<R_xlen_t> seen(n_patterns, -1);
+        HitCounter count = { &thread_strings[t], &thread_occurrences[t], &seen, 0, 1, false };
+
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1024)
+#endif
+        for (R_xlen_t i = 0; i < n_match; i++) {
+            count.current = i;
+            count.weight = weight.empty() ? 1 : weight[i];
+            count.matched = false;
+            matcher.for_each_match(refs.data[i], refs.length[i], count);
+            if (count.matched) n_matched += count.weight;
+        }
+    }
+
+    Rcpp::NumericVector res_strings(n_patterns), res_occurrences(n_patterns);
+    for (int t = 0; t < n_threads; t++) {
+        for (int p = 0; p < n_patterns; p++) {
+            res_strings[p] += static_cast<double>(thread_strings[t][p]);
+            res_occurrences[p] += static_cast<double>(thread_occurrences[t][p]);
+        }
+    }
+
+    return Rcpp::List::create(
+        Rcpp::Named("strings") = res_strings,
+        Rcpp::Named("occurrences") = res_occurrences,
+        Rcpp::Named("n_matched") = static_cast<double>(n_matched)
+    );
+}
@@ -0,0 +1,348 @@
+#ifndef GRAPHFAST_SIMD_SEARCH_H
+#define GRAPHFAST_SIMD_SEARCH_H
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+
+// Vectorized substring kernels with runtime CPU dispatch.
+//
+// x86 builds compile SSE2/SSSE3/AVX2 variants through function target
+// attributes, so the package itself needs no -mavx2, and pick one per call
+// from the detected CPU. Other platforms and compilers use the scalar code.
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define GRAPHFAST_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+namespace simd {
+
+enum Level { SCALAR = 0, SSE2 = 1, SSSE3 = 2, AVX2 = 3 };
+
+static const size_t NOT_FOUND = static_cast<size_t>(-1);
+
+inline int detect_level() {
+#ifdef GRAPHFAST_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return AVX2;
+    if (__builtin_cpu_supports("ssse3")) return SSSE3;
+    if (__builtin_cpu_supports("sse2")) return SSE2;
+#endif
+    return SCALAR;
+}
+
+// Detected level, lowered by set_level_cap() (used to test the fallbacks)
+inline int& level_cap() {
+    static int cap = AVX2;
+    return cap;
+}
+
+inline int level() {
+    static const int detected = detect_level();
+    return std::min(detected, __atomic_load_n(&level_cap(), __ATOMIC_RELAXED));
+}
+
+inline void set_level_cap(int cap) {
+    __atomic_store_n(&level_cap(), std::max(0, std::min(cap, static_cast<int>(AVX2))), __ATOMIC_RELAXED);
+}
+
+inline uint8_t fold_ascii(uint8_t c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<uint8_t>(c + 32) : c;
+}
+
+// text[0, m) equals the (already folded) pattern
+inline bool equal_folded(const uint8_t* text, const uint8_t* pat, size_t m, bool fold) {
+    if (!fold) return std::memcmp(text, pat, m) == 0;
+    for (size_t j = 0; j < m; j++) {
+        if (fold_ascii(text[j]) != pat[j]) return false;
+    }
+    return true;
+}
+
+inline size_t find_scalar(const uint8_t* t, size_t len, const uint8_t* pat, size_t m, bool fold) {
+    if (m > len) return NOT_FOUND;
+    const size_t last = len - m;
+    if (!fold) {
+        const uint8_t* p = t;
+        const uint8_t* end = t + last + 1;
+        while (p < end) {
+            p = static_cast<const uint8_t*>(std::memchr(p, pat[0], end - p));
+            if (p == nullptr) return NOT_FOUND;
+            if (std::memcmp(p + 1, pat + 1, m - 1) == 0) return p - t;
+            p++;
+        }
+        return NOT_FOUND;
+    }
+    for (size_t i = 0; i <= last; i++) {
+        if (fold_ascii(t[i]) == pat[0] && equal_folded(t + i + 1, pat + 1, m - 1, true)) return i;
+    }
+    return NOT_FOUND;
+}
+
+#ifdef GRAPHFAST_X86_SIMD
+
+// Bytes 'A'..'Z' get bit 0x20 set; signed compares leave bytes >= 0x80 alone
+__attribute__((target("sse2")))
+inline __m128i fold_sse2(__m128i x) {
+    __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(x, _mm_set1_epi8('A' - 1)),
+                                  _mm_cmplt_epi8(x, _mm_set1_epi8('Z' + 1)));
+    return _mm_or_si128(x, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+}
+
+__attribute__((target("avx2")))
+inline __m256i fold_avx2(__m256i x) {
+    __m256i upper = _mm256_and_si256(_mm256_cmpgt_epi8(x, _mm256_set1_epi8('A' - 1)),
+                                     _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), x));
+    return _mm256_or_si256(x, _mm256_and_si256(upper, _mm256_set1_epi8(0x20)));
+}
+
+// First-and-last-byte filter (Mula): compare 16 candidate starts at once on
+// the pattern's first and last byte, verify the survivors
+__attribute__((target("sse2")))
+inline size_t find_sse2(const uint8_t* t, size_t len, const uint8_t* pat, size_t m, bool fold) {
+    if (m > len) return NOT_FOUND;
+    const size_t last = len - m;
+    const __m128i first_byte = _mm_set1_epi8(static_cast<char>(pat[0]));
+    const __m128i last_byte = _mm_set1_epi8(static_cast<char>(pat[m - 1]));
+
+    size_t i = 0;
+    for (; i + 15 <= last; i += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(t + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(t + i + m - 1));
+        if (fold) {
+            a = fold_sse2(a);
+            b = fold_sse2(b);
+        }
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(a, first_byte), _mm_cmpeq_epi8(b, last_byte))));
+        while (mask != 0) {
+            const size_t j = __builtin_ctz(mask);
+            if (m <= 2 || equal_folded(t + i + j + 1, pat + 1, m - 2, fold)) return i + j;
+            mask &= mask - 1;
+        }
+    }
+
+    size_t rest = find_scalar(t + i, len - i, pat, m, fold);
+    return rest == NOT_FOUND ? NOT_FOUND : i + rest;
+}
+
+__attribute__((target("avx2")))
+inline size_t find_avx2(const uint8_t* t, size_t len, const uint8_t* pat, size_t m, bool fold) {
+    if (m > len) return NOT_FOUND;
+    const size_t last = len - m;
+    const __m256i first_byte = _mm256_set1_epi8(static_cast<char>(pat[0]));
+    const __m256i last_byte = _mm256_set1_epi8(static_cast<char>(pat[m - 1]));
+
+    size_t i = 0;
+    for (; i + 31 <= last; i += 32) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(t + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(t + i + m - 1));
+        if (fold) {
+            a = fold_avx2(a);
+            b = fold_avx2(b);
+        }
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(a, first_byte), _mm256_cmpeq_epi8(b, last_byte))));
+        while (mask != 0) {
+            const size_t j = __builtin_ctz(mask);
+            if (m <= 2 || equal_folded(t + i + j + 1, pat + 1, m - 2, fold)) return i + j;
+            mask &= mask - 1;
+        }
+    }
+
+    size_t rest = find_sse2(t + i, len - i, pat, m, fold);
+    return rest == NOT_FOUND ? NOT_FOUND : i + rest;
+}
+
+#endif
+
+inline bool is_ascii_scalar(const uint8_t* t, size_t len) {
+    uint8_t high = 0;
+    for (size_t i = 0; i < len; i++) high |= t[i];
+    return high < 0x80;
+}
+
+#ifdef GRAPHFAST_X86_SIMD
+__attribute__((target("sse2")))
+inline bool is_ascii_sse2(const uint8_t* t, size_t len) {
+    size_t i = 0;
+    __m128i high = _mm_setzero_si128();
+    for (; i + 16 <= len; i += 16) {
+        high = _mm_or_si128(high, _mm_loadu_si128(reinterpret_cast<const __m128i*>(t + i)));
+    }
+    return _mm_movemask_epi8(high) == 0 && is_ascii_scalar(t + i, len - i);
+}
+
+__attribute__((target("avx2")))
+inline bool is_ascii_avx2(const uint8_t* t, size_t len) {
+    size_t i = 0;
+    __m256i high = _mm256_setzero_si256();
+    for (; i + 32 <= len; i += 32) {
+        high = _mm256_or_si256(high, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(t + i)));
+    }
+    return _mm256_movemask_epi8(high) == 0 && is_ascii_sse2(t + i, len - i);
+}
+#endif
+
+// True if no byte has the high bit set
+inline bool is_ascii(const char* text, size_t len) {
+    const uint8_t* t = reinterpret_cast<const uint8_t*>(text);
+#ifdef GRAPHFAST_X86_SIMD
+    const int lvl = level();
+    if (lvl >= AVX2) return is_ascii_avx2(t, len);
+    if (lvl >= SSE2) return is_ascii_sse2(t, len);
+#endif
+    return is_ascii_scalar(t, len);
+}
+
+// First occurrence of a non-empty, already folded pattern in text. With
+// fold, ASCII letters in the text are lower-cased on the fly.
+inline size_t find(const char* text, size_t len, const char* pattern, size_t m, bool fold) {
+    const uint8_t* t = reinterpret_cast<const uint8_t*>(text);
+    const uint8_t* pat = reinterpret_cast<const uint8_t*>(pattern);
+#ifdef GRAPHFAST_X86_SIMD
+    const int lvl = level();
+    if (lvl >= AVX2) return find_avx2(t, len, pat, m, fold);
+    if (lvl >= SSE2) return find_sse2(t, len, pat, m, fold);
+#endif
+    return find_scalar(t, len, pat, m, fold);
+}
+
+// Teddy-style packed literal matcher (after the Hyperscan / Rust regex
+// design). Patterns are grouped into 8 buckets; for each of the first
+// `prefix` bytes, two 16-entry tables map the low and high nibble of a text
+// byte to the buckets that byte is compatible with. PSHUFB evaluates both
+// tables for 16 positions at once and the AND over prefix bytes leaves the
+// candidate (position, bucket) pairs, which are verified in full.
+class Teddy {
+public:
+    static const int MAX_PATTERNS = 64;
+    static const int MAX_PREFIX = 3;
+
+    Teddy() : prefix_(0), fold_(false) {}
+
+    // False (and unusable) for an empty or empty-pattern set or too many
+    // patterns; patterns must already be folded when fold is set
+    bool build(const std::vector<std::string>& patterns, bool fold) {
+        prefix_ = 0;
+        fold_ = fold;
+        patterns_.clear();
+        if (patterns.empty() || static_cast<int>(patterns.size()) > MAX_PATTERNS) return false;
+
+        size_t min_len = patterns[0].size();
+        for (size_t p = 0; p < patterns.size(); p++) min_len = std::min(min_len, patterns[p].size());
+        if (min_len == 0) return false;
+        const int prefix = static_cast<int>(std::min<size_t>(MAX_PREFIX, min_len));
+
+        // Similar prefixes share a bucket, which keeps false candidates rare
+        patterns_ = patterns;
+        std::sort(patterns_.begin(), patterns_.end());
+        patterns_.erase(std::unique(patterns_.begin(), patterns_.end()), patterns_.end());
+
+        const int n = static_cast<int>(patterns_.size());
+        std::memset(lo_, 0, sizeof(lo_));
+        std::memset(hi_, 0, sizeof(hi_));
+        for (int b = 0; b <= 8; b++) bucket_begin_[b] = n * b / 8;
+        for (int b = 0; b < 8; b++) {
+            for (int p = bucket_begin_[b]; p < bucket_begin_[b + 1]; p++) {
+                for (int k = 0; k < prefix; k++) {
+                    uint8_t c = static_cast<uint8_t>(patterns_[p][k]);
+                    lo_[k][c & 0x0F] |= static_cast<uint8_t>(1u << b);
+                    hi_[k][c >> 4] |= static_cast<uint8_t>(1u << b);
+                }
+            }
+        }
+        prefix_ = prefix;
+        return true;
+    }
+
+    bool ready() const { return prefix_ > 0; }
+
+    bool any(const char* text, size_t len) const {
+        const uint8_t* t = reinterpret_cast<const uint8_t*>(text);
+        size_t i = 0;
+#ifdef GRAPHFAST_X86_SIMD
+        if (level() >= SSSE3) {
+            if (scan_ssse3(t, len, i)) return true;
+        }
+#endif
+        for (; i < len; i++) {
+            uint8_t buckets = 0xFF;
+            for (int k = 0; k < prefix_ && buckets != 0; k++) {
+                if (i + k >= len) return false;
+                uint8_t c = fold_ ? fold_ascii(t[i + k]) : t[i + k];
+                buckets &= lo_[k][c & 0x0F] & hi_[k][c >> 4];
+            }
+            if (buckets != 0 && verify(t, len, i, buckets)) return true;
+        }
+        return false;
+    }
+
+private:
+    int prefix_;
+    bool fold_;
+    std::vector<std::string> patterns_;
+    int bucket_begin_[9];
+    uint8_t lo_[MAX_PREFIX][16];
+    uint8_t hi_[MAX_PREFIX][16];
+
+    bool verify(const uint8_t* t, size_t len, size_t start, unsigned buckets) const {
+        while (buckets != 0) {
+            const int b = __builtin_ctz(buckets);
+            buckets &= buckets - 1;
+            for (int p = bucket_begin_[b]; p < bucket_begin_[b + 1]; p++) {
+                const std::string& pattern = patterns_[p];
+                if (pattern.size() <= len - start &&
+                    equal_folded(t + start, reinterpret_cast<const uint8_t*>(pattern.data()),
+                                 pattern.size(), fold_)) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+#ifdef GRAPHFAST_X86_SIMD
+    // Processes whole 16-byte blocks; on return `i` is where the scalar tail
+    // continues
+    __attribute__((target("ssse3")))
+    bool scan_ssse3(const uint8_t* t, size_t len, size_t& i) const {
+        const __m128i nibble = _mm_set1_epi8(0x0F);
+        __m128i lo[MAX_PREFIX], hi[MAX_PREFIX];
+        for (int k = 0; k < prefix_; k++) {
+            lo[k] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lo_[k]));
+            hi[k] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(hi_[k]));
+        }
+
+        alignas(16) uint8_t buckets[16];
+        for (i = 0; i + 16 + prefix_ - 1 <= len; i += 16) {
+            __m128i match = _mm_set1_epi8(static_cast<char>(0xFF));
+            for (int k = 0; k < prefix_; k++) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(t + i + k));
+                if (fold_) v = fold_sse2(v);
+                __m128i low = _mm_shuffle_epi8(lo[k], _mm_and_si128(v, nibble));
+                __m128i high = _mm_shuffle_epi8(hi[k], _mm_and_si128(_mm_srli_epi16(v, 4), nibble));
+                match = _mm_and_si128(match, _mm_and_si128(low, high));
+            }
+            unsigned candidates = 0xFFFF & ~static_cast<unsigned>(
+                _mm_movemask_epi8(_mm_cmpeq_epi8(match, _mm_setzero_si128())));
+            if (candidates == 0) continue;
+
+            _mm_store_si128(reinterpret_cast<__m128i*>(buckets), match);
+            while (candidates != 0) {
+                const int j = __builtin_ctz(candidates);
+                candidates &= candidates - 1;
+                if (verify(t, len, i + j, buckets[j])) return true;
+            }
+        }
+        return false;
+    }
+#endif
+};
+
+}  // namespace simd
+
+#endif
@@ -0,0 +1,231 @@
+#include <Rcpp.h>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <chrono>
+#include <cstring>
+#include "string_set.h"
+#include "pattern_matcher.h"
+#include "parallel_utils.h"
+
+static const char STRING_SET_MAGIC[8] = {'G', 'F', 'S', 'S', 'v', '1', '\0', '\0'};
+static const uint32_t STRING_SET_BYTE_ORDER = 0x01020304;
+
+// Header: magic, byte order, fp_bits, has_positions, n_levels (4 bytes
+// each after the magic), then n_keys, n_placed, n_words, n_rank, n_fallback
+// (8 bytes each), then the level offsets and sizes, then the arrays
+struct StringSetHeader {
+    char magic[8];
+    uint32_t byte_order;
+    int32_t fp_bits;
+    int32_t has_positions;
+    int32_t n_levels;
+    int64_t n_keys, n_placed, n_words, n_rank, n_fallback;
+};
+
+bool CompactStringSet::save(const std::string& path) const {
+    std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+    if (!out) return false;
+
+    StringSetHeader header;
+    std::memcpy(header.magic, STRING_SET_MAGIC, sizeof(header.magic));
+    header.byte_order = STRING_SET_BYTE_ORDER;
+    header.fp_bits = fp_bits_;
+    header.has_positions = has_positions_ ? 1 : 0;
+    header.n_levels = n_levels_;
+    header.n_keys = n_keys_;
+    header.n_placed = n_placed_;
+    header.n_words = n_words_;
+    header.n_rank = n_rank_;
+    header.n_fallback = n_fallback_;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    out.write(reinterpret_cast<const char*>(level_offset_.data()), n_levels_ * sizeof(uint64_t));
+    out.write(reinterpret_cast<const char*>(level_size_.data()), n_levels_ * sizeof(uint64_t));
+    out.write(reinterpret_cast<const char*>(bits_), n_words_ * sizeof(uint64_t));
+    out.write(reinterpret_cast<const char*>(rank_), n_rank_ * sizeof(uint64_t));
+    out.write(reinterpret_cast<const char*>(fallback_), n_fallback_ * sizeof(uint64_t));
+    out.write(reinterpret_cast<const char*>(fp_), padded_bytes(n_keys_ * (fp_bits_ / 8)));
+    if (has_positions_) {
+        out.write(reinterpret_cast<const char*>(positions_), padded_bytes(n_keys_ * 4));
+    }
+    return static_cast<bool>(out);
+}
+
+bool CompactStringSet::load(const std::string& path) {
+    if (!file_.open(path) || file_.size() < sizeof(StringSetHeader)) return false;
+
+    StringSetHeader header;
+    std::memcpy(&header, file_.data(), sizeof(header));
+    if (std::memcmp(header.magic, STRING_SET_MAGIC, sizeof(header.magic)) != 0 ||
+        header.byte_order != STRING_SET_BYTE_ORDER ||
+        (header.fp_bits != 8 && header.fp_bits != 16 && header.fp_bits != 32) ||
+        header.n_levels < 0 || header.n_levels > MAX_LEVELS || header.n_keys < 0 ||
+        header.n_placed < 0 || header.n_words < 0 || header.n_rank != header.n_words / 8 + 1 || header.n_fallback < 0 ||
+        header.n_placed + header.n_fallback != header.n_keys) {
+        return false;
+    }
+
+    fp_bits_ = header.fp_bits;
+    has_positions_ = header.has_positions != 0;
+    n_levels_ = header.n_levels;
+    n_keys_ = header.n_keys;
+    n_placed_ = header.n_placed;
+    n_words_ = header.n_words;
+    n_rank_ = header.n_rank;
+    n_fallback_ = header.n_fallback;
+
+    const size_t expected = sizeof(header) + 2 * n_levels_ * sizeof(uint64_t) +
+                            (n_words_ + n_rank_ + n_fallback_) * sizeof(uint64_t) +
+                            padded_bytes(n_keys_ * (fp_bits_ / 8)) +
+                            (has_positions_ ? padded_bytes(n_keys_ * 4) : 0);
+    if (file_.size() != expected) return false;
+
+    // Arrays are used in place; every section starts 8-byte aligned
+    const char* p = file_.data() + sizeof(header);
+    level_offset_.resize(n_levels_);
+    level_size_.resize(n_levels_);
+    std::memcpy(level_offset_.data(), p, n_levels_ * sizeof(uint64_t));
+    p += n_levels_ * sizeof(uint64_t);
+    std::memcpy(level_size_.data(), p, n_levels_ * sizeof(uint64_t));
+    p += n_levels_ * sizeof(uint64_t);
+    bits_ = reinterpret_cast<const uint64_t*>(p);
+    p += n_words_ * sizeof(uint64_t);
+    rank_ = reinterpret_cast<const uint64_t*>(p);
+    p += n_rank_ * sizeof(uint64_t);
+    fallback_ = reinterpret_cast<const uint64_t*>(p);
+    p += n_fallback_ * sizeof(uint64_t);
+    fp_ = reinterpret_cast<const uint8_t*>(p);
+    p += padded_bytes(n_keys_ * (fp_bits_ / 8));
+    positions_ = has_positions_ ? reinterpret_cast<const int32_t*>(p) : NULL;
+
+    for (int level = 0; level < n_levels_; level++) {
+        if (level_size_[level] == 0 || level_size_[level] % 64 != 0 ||
+            level_offset_[level] + level_size_[level] > static_cast<uint64_t>(n_words_) * 64) {
+            return false;
+        }
+    }
+
+    // The rank directory must end at n_placed (the last entry plus the set
+    // bits of a final partial block); find() rejects any larger index
+    uint64_t placed = rank_[n_rank_ - 1];
+    for (int64_t w = 8 * (n_rank_ - 1); w < n_words_; w++) placed += popcount(bits_[w]);
+    return placed == static_cast<uint64_t>(n_placed_);
+}
+
+static Rcpp::List string_set_info(const Rcpp::XPtr<CompactStringSet>& ptr, double build_seconds) {
+    const CompactStringSet* set = ptr.get();
+    return Rcpp::List::create(
+        Rcpp::Named("ptr") = ptr,
+        Rcpp::Named("n_keys") = static_cast<double>(set->n_keys()),
+        Rcpp::Named("fingerprint_bits") = set->fp_bits(),
+        Rcpp::Named("positions") = set->has_positions(),
+        Rcpp::Named("n_levels") = set->n_levels(),
+        Rcpp::Named("memory_bytes") = set->memory_bytes(),
+        Rcpp::Named("build_seconds") = build_seconds
+    );
+}
+
+static const CompactStringSet* get_string_set(SEXP ptr) {
+    Rcpp::XPtr<CompactStringSet> xp(ptr);
+    if (xp.get() == nullptr) {
+        Rcpp::stop("String set is no longer valid (external pointers do not survive saveRDS or "
+                   "a new session). Use save_string_set() and load_string_set().");
+    }
+    return xp.get();
+}
+
+//' Build a Compact String Set
+//'
+//' @param dictionary Character vector of keys (NA is stored as "NA")
+//' @param fp_bits Fingerprint bits per key: 8, 16 or 32
+//' @param positions Whether to store each key's position in dictionary
+//' @param n_threads Number of threads; <= 0 uses all available
+//' @return List with the external pointer, key count, fingerprint bits,
+//'   whether positions are stored, level count, memory use and build time
+// [[Rcpp::export]]
+Rcpp::List build_string_set_cpp(const Rcpp::CharacterVector& dictionary, int fp_bits = 32,
+                                bool positions = false, int n_threads = 0) {
+    if (fp_bits != 8 && fp_bits != 16 && fp_bits != 32) {
+        Rcpp::stop("fingerprint bits must be 8, 16 or 32");
+    }
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    const StringRefs refs(dictionary);
+    CompactStringSet* set = new CompactStringSet();
+    Rcpp::XPtr<CompactStringSet> ptr(set, true);
+    set->build(refs.data.data(), refs.length.data(), refs.size(), fp_bits, positions, n_threads);
+
+    const double build_seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    return string_set_info(ptr, build_seconds);
+}
+
+//' Save a Compact String Set
+//'
+//' @param set_ptr External pointer returned by build_string_set_cpp
+//' @param path Output file path
+// [[Rcpp::export]]
+void save_string_set_cpp(SEXP set_ptr, std::string path) {
+    if (!get_string_set(set_ptr)->save(path)) {
+        Rcpp::stop("Failed writing string set to '%s'", path);
+    }
+}
+
+//' Load a Compact String Set
+//'
+//' Memory-maps a file written by save_string_set_cpp; the arrays are used in
+//' place, so loading costs no reading or rebuilding.
+//'
+//' @param path File written by save_string_set_cpp
+//' @return Same list structure as build_string_set_cpp
+// [[Rcpp::export]]
+Rcpp::List load_string_set_cpp(std::string path) {
+    CompactStringSet* set = new CompactStringSet();
+    Rcpp::XPtr<CompactStringSet> ptr(set, true);
+    if (!set->load(path)) {
+        Rcpp::stop("'%s' is not a graphfast string set, is truncated, or was saved on a host "
+                   "with a different byte order", path);
+    }
+    return string_set_info(ptr, 0.0);
+}
+
+//' Query a Compact String Set
+//'
+//' @param set_ptr External pointer of a string set
+//' @param strings Character vector of strings to look up
+//' @param match Return dictionary positions (1-based, NA if absent) instead
+//'   of membership; requires a set built with positions
+//' @param n_threads Number of threads; <= 0 uses all available
+//' @return Logical vector, or integer vector with match = TRUE
+// [[Rcpp::export]]
+SEXP query_string_set_cpp(SEXP set_ptr, const Rcpp::CharacterVector& strings, bool match = false,
+                          int n_threads = 0) {
+    const CompactStringSet& set = *get_string_set(set_ptr);
+    if (match && !set.has_positions()) {
+        Rcpp::stop("the string set was built without positions");
+    }
+    const StringRefs refs(strings);
+    const R_xlen_t n_strings = refs.size();
+    n_threads = matching_threads(n_threads, n_strings);
+
+    Rcpp::IntegerVector positions(match ? n_strings : 0);
+    Rcpp::LogicalVector found(match ? 0 : n_strings);
+    int* out = match ? INTEGER(positions) : LOGICAL(found);
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(n_threads) schedule(dynamic, 1024)
+#endif
+    for (R_xlen_t i = 0; i < n_strings; i++) {
+        const int64_t index = set.find(refs.data[i], static_cast<size_t>(refs.length[i]));
+        if (match) {
+            const int position = index < 0 ? 0 : set.position(index);
+            out[i] = position > 0 ? position : NA_INTEGER;
+        } else {
+            out[i] = index >= 0;
+        }
+    }
+
+    if (match) return positions;
+    return found;
+}
@@ -0,0 +1,353 @@
+#ifndef GRAPHFAST_STRING_SET_H
+#define GRAPHFAST_STRING_SET_H
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+#include "mapped_file.h"
+#include "parallel_utils.h"
+
+// 128-bit hash of a byte string: MurmurHash3_x64_128 (Appleby, public
+// domain). Blocks are read with memcpy, i.e. in host byte order, so saved
+// sets record the byte order and are only loaded on hosts that match.
+struct StringHash {
+    uint64_t h1, h2;
+};
+
+inline uint64_t murmur_rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+inline uint64_t murmur_fmix(uint64_t k) {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+}
+
+inline StringHash hash_string(const char* data, size_t len, uint64_t seed) {
+    const uint64_t c1 = 0x87c37b91114253d5ULL, c2 = 0x4cf5ad432745937fULL;
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(data);
+    const size_t n_blocks = len / 16;
+    uint64_t h1 = seed, h2 = seed;
+
+    for (size_t b = 0; b < n_blocks; b++) {
+        uint64_t k1, k2;
+        std::memcpy(&k1, p + b * 16, 8);
+        std::memcpy(&k2, p + b * 16 + 8, 8);
+        k1 *= c1; k1 = murmur_rotl(k1, 31); k1 *= c2; h1 ^= k1;
+        h1 = murmur_rotl(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+        k2 *= c2; k2 = murmur_rotl(k2, 33); k2 *= c1; h2 ^= k2;
+        h2 = murmur_rotl(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+    }
+
+    const uint8_t* tail = p + n_blocks * 16;
+    uint64_t k1 = 0, k2 = 0;
+    switch (len & 15) {
+    case 15: k2 ^= uint64_t(tail[14]) << 48;  // fall through
+    case 14: k2 ^= uint64_t(tail[13]) << 40;  // fall through
+    case 13: k2 ^= uint64_t(tail[12]) << 32;  // fall through
+    case 12: k2 ^= uint64_t(tail[11]) << 24;  // fall through
+    case 11: k2 ^= uint64_t(tail[10]) << 16;  // fall through
+    case 10: k2 ^= uint64_t(tail[9]) << 8;    // fall through
+    case 9:  k2 ^= uint64_t(tail[8]);
+             k2 *= c2; k2 = murmur_rotl(k2, 33); k2 *= c1; h2 ^= k2;  // fall through
+    case 8:  k1 ^= uint64_t(tail[7]) << 56;   // fall through
+    case 7:  k1 ^= uint64_t(tail[6]) << 48;   // fall through
+    case 6:  k1 ^= uint64_t(tail[5]) << 40;   // fall through
+    case 5:  k1 ^= uint64_t(tail[4]) << 32;   // fall through
+    case 4:  k1 ^= uint64_t(tail[3]) << 24;   // fall through
+    case 3:  k1 ^= uint64_t(tail[2]) << 16;   // fall through
+    case 2:  k1 ^= uint64_t(tail[1]) << 8;    // fall through
+    case 1:  k1 ^= uint64_t(tail[0]);
+             k1 *= c1; k1 = murmur_rotl(k1, 31); k1 *= c2; h1 ^= k1;
+    }
+
+    h1 ^= len; h2 ^= len;
+    h1 += h2; h2 += h1;
+    h1 = murmur_fmix(h1); h2 = murmur_fmix(h2);
+    h1 += h2; h2 += h1;
+    StringHash h = { h1, h2 };
+    return h;
+}
+
+// Static set of strings: a minimal perfect hash function plus a fingerprint
+// per key.
+//
+// The hash function is BBHash-style (Limasset et al., 2017): at each level
+// every remaining key hashes into a bit array of GAMMA bits per key; keys
+// alone in their slot set the bit and are done, colliding keys move on to
+// the next level. A key's index is the rank of its bit over all levels, so
+// n keys get the indices 0..n-1 using about 3.7 bits each including the rank
+// directory. Keys still colliding after MAX_LEVELS levels (in practice only
+// distinct strings sharing a 64-bit hash) are kept in a sorted fallback
+// table.
+//
+// The function maps any string to some index, so the set also stores a
+// fingerprint of every key (fp_bits of a second, independent hash) and
+// optionally the key's position in the original dictionary. A string not in
+// the set is reported as a member with probability 2^-fp_bits; members are
+// always found.
+//
+// All arrays live in one contiguous, 8-byte aligned layout, so a saved set
+// is used directly from a memory map without being read or rebuilt.
+class CompactStringSet {
+public:
+    static const int GAMMA = 2;
+    static const int MAX_LEVELS = 32;
+    static const uint64_t SEED = 0x6772617068666173ULL;  // "graphfas"
+
+    CompactStringSet() : n_keys_(0), n_placed_(0), n_levels_(0), fp_bits_(32), has_positions_(false) { point(); }
+
+    // Builds the set from n strings (pointers and byte lengths). Equal
+    // strings are stored once, at the position of their first occurrence.
+    void build(const char* const* data, const int* length, int64_t n, int fp_bits,
+               bool store_positions, int n_threads) {
+        fp_bits_ = fp_bits;
+        has_positions_ = store_positions;
+        n_threads = resolve_threads(n_threads);
+
+        std::vector<StringHash> hash(n);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(n_threads) schedule(static)
+#endif
+        for (int64_t i = 0; i < n; i++) hash[i] = hash_string(data[i], static_cast<size_t>(length[i]), SEED);
+
+        // Levels: `keys` holds the dictionary positions still unplaced
+        std::vector<int64_t> keys(n);
+        for (int64_t i = 0; i < n; i++) keys[i] = i;
+        std::vector<int64_t> placed;
+        std::vector<uint64_t> bits;
+        level_offset_.clear();
+        level_size_.clear();
+
+        while (!keys.empty() && static_cast<int>(level_size_.size()) < MAX_LEVELS) {
+            const int level = static_cast<int>(level_size_.size());
+            const uint64_t size = ((static_cast<uint64_t>(keys.size()) * GAMMA + 63) / 64) * 64;
+            const uint64_t offset = static_cast<uint64_t>(bits.size()) * 64;
+            level_offset_.push_back(offset);
+            level_size_.push_back(size);
+
+            std::vector<uint64_t> seen(size / 64, 0), collision(size / 64, 0);
+            const int64_t n_keys = static_cast<int64_t>(keys.size());
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(n_threads) schedule(static)
+#endif
+            for (int64_t k = 0; k < n_keys; k++) {
+                const uint64_t slot = level_slot(hash[keys[k]].h1, level, size);
+                const uint64_t bit = uint64_t(1) << (slot & 63);
+                uint64_t before;
+#ifdef _OPENMP
+#pragma omp atomic capture
+#endif
+                { before = seen[slot >> 6]; seen[slot >> 6] |= bit; }
+                if (before & bit) {
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+                    collision[slot >> 6] |= bit;
+                }
+            }
+
+            for (size_t w = 0; w < seen.size(); w++) seen[w] &= ~collision[w];
+            bits.insert(bits.end(), seen.begin(), seen.end());
+
+            std::vector<int64_t> next;
+            for (int64_t k = 0; k < n_keys; k++) {
+                const uint64_t slot = level_slot(hash[keys[k]].h1, level, size);
+                if ((collision[slot >> 6] >> (slot & 63)) & 1) {
+                    next.push_back(keys[k]);
+                } else {
+                    placed.push_back(keys[k]);
+                }
+            }
+            keys.swap(next);
+
+            // Equal strings collide on every level, so all duplicates are
+            // among the few keys left after two levels: drop them there
+            if (level == 1) {
+                sort_by_hash(keys, hash);
+                size_t kept = 0;
+                for (size_t k = 0; k < keys.size(); k++) {
+                    if (kept > 0 && hash[keys[k]].h1 == hash[keys[kept - 1]].h1 &&
+                        hash[keys[k]].h2 == hash[keys[kept - 1]].h2) {
+                        continue;
+                    }
+                    keys[kept++] = keys[k];
+                }
+                keys.resize(kept);
+            }
+        }
+        bits_store_.swap(bits);
+        n_levels_ = static_cast<int>(level_size_.size());
+
+        // Rank directory: set bits before every block of 8 words
+        const size_t n_words = bits_store_.size();
+        rank_store_.assign(n_words / 8 + 1, 0);
+        uint64_t total = 0;
+        for (size_t w = 0; w < n_words; w++) {
+            if (w % 8 == 0) rank_store_[w / 8] = total;
+            total += popcount(bits_store_[w]);
+        }
+        if (n_words % 8 == 0) rank_store_[n_words / 8] = total;
+        n_placed_ = static_cast<int64_t>(total);
+
+        // Fallback: leftover keys with a shared h1 (distinct h2)
+        sort_by_hash(keys, hash);
+        fallback_store_.resize(keys.size());
+        for (size_t k = 0; k < keys.size(); k++) fallback_store_[k] = hash[keys[k]].h1;
+        const std::vector<int64_t>& fallback_key = keys;
+        n_keys_ = n_placed_ + static_cast<int64_t>(fallback_key.size());
+
+        // Fingerprints and positions by index
+        fp_store_.assign(padded_bytes(n_keys_ * (fp_bits_ / 8)), 0);
+        positions_store_.assign(has_positions_ ? padded_bytes(n_keys_ * 4) / 4 : 0, 0);
+        point();
+        const int64_t n_placed = static_cast<int64_t>(placed.size());
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(n_threads) schedule(static)
+#endif
+        for (int64_t k = 0; k < n_placed; k++) {
+            const int64_t i = placed[k];
+            set_key(placed_index(hash[i].h1), hash[i].h2, i);
+        }
+        for (size_t k = 0; k < fallback_key.size(); k++) {
+            set_key(n_placed_ + static_cast<int64_t>(k), hash[fallback_key[k]].h2, fallback_key[k]);
+        }
+    }
+
+    // Index of the key equal to text, or -1 if it is not in the set
+    int64_t find(const char* text, size_t len) const {
+        const StringHash h = hash_string(text, len, SEED);
+        const uint32_t fp = fingerprint(h.h2);
+        const int64_t index = placed_index(h.h1);
+        if (index >= n_placed_) return -1;
+        if (index >= 0) return fingerprint_at(index) == fp ? index : -1;
+
+        const uint64_t* end = fallback_ + n_fallback_;
+        for (const uint64_t* it = std::lower_bound(fallback_, end, h.h1); it != end && *it == h.h1; it++) {
+            const int64_t k = n_placed_ + (it - fallback_);
+            if (fingerprint_at(k) == fp) return k;
+        }
+        return -1;
+    }
+
+    // 1-based position in the dictionary of key `index` (with positions),
+    // or 0 if the stored position is invalid
+    int position(int64_t index) const {
+        const int32_t p = positions_[index];
+        return p >= 0 && p < INT32_MAX ? p + 1 : 0;
+    }
+
+    int64_t n_keys() const { return n_keys_; }
+    int fp_bits() const { return fp_bits_; }
+    bool has_positions() const { return has_positions_; }
+    int n_levels() const { return n_levels_; }
+
+    double memory_bytes() const {
+        return static_cast<double>((n_words_ + n_rank_ + n_fallback_) * 8 +
+                                   padded_bytes(n_keys_ * (fp_bits_ / 8)) +
+                                   (has_positions_ ? padded_bytes(n_keys_ * 4) : 0));
+    }
+
+    // Binary layout: header, level table, then each array padded to 8 bytes
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+
+private:
+    int64_t n_keys_;
+    int64_t n_placed_;    // keys with a bit in some level; the rest are in the fallback
+    int n_levels_;
+    int fp_bits_;
+    bool has_positions_;
+    std::vector<uint64_t> level_offset_, level_size_;
+
+    // Owned storage of a built set; a loaded set points into `file_` instead
+    std::vector<uint64_t> bits_store_, rank_store_, fallback_store_;
+    std::vector<uint8_t> fp_store_;
+    std::vector<int32_t> positions_store_;
+    MappedFile file_;
+
+    const uint64_t* bits_;
+    const uint64_t* rank_;
+    const uint64_t* fallback_;
+    const uint8_t* fp_;
+    const int32_t* positions_;
+    int64_t n_words_, n_rank_, n_fallback_;
+
+    static int popcount(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_popcountll(x);
+#else
+        int c = 0;
+        for (; x; x &= x - 1) c++;
+        return c;
+#endif
+    }
+
+    // By (h1, h2), then dictionary position
+    static void sort_by_hash(std::vector<int64_t>& keys, const std::vector<StringHash>& hash) {
+        std::sort(keys.begin(), keys.end(), [&hash](int64_t a, int64_t b) {
+            if (hash[a].h1 != hash[b].h1) return hash[a].h1 < hash[b].h1;
+            if (hash[a].h2 != hash[b].h2) return hash[a].h2 < hash[b].h2;
+            return a < b;
+        });
+    }
+
+    static size_t padded_bytes(int64_t bytes) { return static_cast<size_t>((bytes + 7) / 8 * 8); }
+
+    static uint64_t level_slot(uint64_t h1, int level, uint64_t size) {
+        uint64_t x = h1 + static_cast<uint64_t>(level + 1) * 0x9E3779B97F4A7C15ULL;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        x ^= x >> 31;
+        return x % size;
+    }
+
+    uint32_t fingerprint(uint64_t h2) const {
+        return fp_bits_ == 32 ? static_cast<uint32_t>(h2) : static_cast<uint32_t>(h2 & ((uint64_t(1) << fp_bits_) - 1));
+    }
+
+    uint32_t fingerprint_at(int64_t index) const {
+        uint32_t fp = 0;
+        std::memcpy(&fp, fp_ + index * (fp_bits_ / 8), fp_bits_ / 8);
+        return fp;
+    }
+
+    void set_key(int64_t index, uint64_t h2, int64_t position) {
+        const uint32_t fp = fingerprint(h2);
+        std::memcpy(&fp_store_[index * (fp_bits_ / 8)], &fp, fp_bits_ / 8);
+        if (has_positions_) positions_store_[index] = static_cast<int32_t>(position);
+    }
+
+    // Rank of the key's bit, or -1 if it collided on every level
+    int64_t placed_index(uint64_t h1) const {
+        for (int level = 0; level < n_levels_; level++) {
+            const uint64_t pos = level_offset_[level] + level_slot(h1, level, level_size_[level]);
+            const uint64_t word = pos >> 6;
+            const uint64_t bit = uint64_t(1) << (pos & 63);
+            if (!(bits_[word] & bit)) continue;
+            uint64_t rank = rank_[word / 8];
+            for (uint64_t w = word & ~uint64_t(7); w < word; w++) rank += popcount(bits_[w]);
+            return static_cast<int64_t>(rank + popcount(bits_[word] & (bit - 1)));
+        }
+        return -1;
+    }
+
+    // Array pointers for owned storage
+    void point() {
+        bits_ = bits_store_.data();
+        rank_ = rank_store_.data();
+        fallback_ = fallback_store_.data();
+        fp_ = fp_store_.data();
+        positions_ = positions_store_.data();
+        n_words_ = static_cast<int64_t>(bits_store_.size());
+        n_rank_ = static_cast<int64_t>(rank_store_.size());
+        n_fallback_ = static_cast<int64_t>(fallback_store_.size());
+    }
+};
+
+#endif
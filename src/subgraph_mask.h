@@ -0,0 +1,65 @@
+#ifndef GRAPHFAST_SUBGRAPH_MASK_H
+#define GRAPHFAST_SUBGRAPH_MASK_H
+
+#include <Rcpp.h>
+#include <cstdint>
+
+// Optional edge and node masks that restrict a kernel to a subgraph without
+// copying the edge matrix. Each mask is NULL (keep everything), a logical
+// vector (TRUE keeps; FALSE and NA drop) or a raw bitset as produced by
+// packBits() (bit i of the vector keeps element i). An edge is kept when it
+// and both of its endpoints are kept.
+//
+// The class only holds pointers into the R vectors, so it is safe to read
+// from worker threads.
+class SubgraphMask {
+private:
+    const int* edge_lgl;
+    const unsigned char* edge_bits;
+    const int* node_lgl;
+    const unsigned char* node_bits;
+
+    static void bind(SEXP mask, R_xlen_t n, const char* what, const char* unit,
+                     const int*& lgl, const unsigned char*& bits) {
+        lgl = nullptr;
+        bits = nullptr;
+        if (Rf_isNull(mask)) return;
+
+        if (TYPEOF(mask) == LGLSXP) {
+            if (XLENGTH(mask) != n) {
+                Rcpp::stop("%s must have one entry per %s", what, unit);
+            }
+            lgl = LOGICAL(mask);
+        } else if (TYPEOF(mask) == RAWSXP) {
+            if (XLENGTH(mask) < (n + 7) / 8) {
+                Rcpp::stop("%s bitset is too short", what);
+            }
+            bits = RAW(mask);
+        } else {
+            Rcpp::stop("%s must be a logical vector or a raw bitset", what);
+        }
+    }
+
+    static bool test(const int* lgl, const unsigned char* bits, int64_t i) {
+        if (lgl != nullptr) return lgl[i] == 1;
+        if (bits != nullptr) return (bits[i >> 3] >> (i & 7)) & 1;
+        return true;
+    }
+
+public:
+    SubgraphMask(SEXP edge_mask, R_xlen_t n_edges, SEXP node_mask, int n_nodes) {
+        bind(edge_mask, n_edges, "edge_mask", "edge", edge_lgl, edge_bits);
+        bind(node_mask, n_nodes, "node_mask", "node", node_lgl, node_bits);
+    }
+
+    bool has_edge_mask() const { return edge_lgl != nullptr || edge_bits != nullptr; }
+    bool has_node_mask() const { return node_lgl != nullptr || node_bits != nullptr; }
+
+    bool edge(int64_t i) const { return test(edge_lgl, edge_bits, i); }
+    bool node(int u) const { return test(node_lgl, node_bits, u); }
+
+    // Edge row i with 0-based endpoints u and v
+    bool keep(int64_t i, int u, int v) const { return edge(i) && node(u) && node(v); }
+};
+
+#endif
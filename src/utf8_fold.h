@@ -0,0 +1,149 @@
+#ifndef GRAPHFAST_UTF8_FOLD_H
+#define GRAPHFAST_UTF8_FOLD_H
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// Simple Unicode case folding for UTF-8 text.
+//
+// Each code point folds to at most one other code point (Unicode simple
+// folding, taken from str.casefold() over the BMP, Unicode 14). Mappings
+// whose UTF-8 encodings differ in length are left out (KELVIN SIGN,
+// LATIN CAPITAL LETTER I WITH DOT ABOVE, CAPITAL SHARP S, ...), so folding
+// never changes byte offsets and ASCII text only ever folds to ASCII. Full
+// foldings such as sharp s -> "ss" are not applied.
+
+// Runs of code points first, first + stride, ... (count of them) that fold
+// to themselves plus delta
+struct FoldRange {
+    uint32_t first;
+    uint16_t count;
+    int32_t delta;
+    uint8_t stride;
+};
+
+static const FoldRange UTF8_FOLD_RANGES[] = {
+    {0x00B5, 1, 775, 1}, {0x00C0, 23, 32, 1}, {0x00D8, 7, 32, 1}, {0x0100, 24, 1, 2},
+    {0x0132, 3, 1, 2}, {0x0139, 8, 1, 2}, {0x014A, 23, 1, 2}, {0x0178, 1, -121, 1},
+    {0x0179, 3, 1, 2}, {0x0181, 1, 210, 1}, {0x0182, 2, 1, 2}, {0x0186, 1, 206, 1},
+    {0x0187, 1, 1, 1}, {0x0189, 2, 205, 1}, {0x018B, 1, 1, 1}, {0x018E, 1, 79, 1},
+    {0x018F, 1, 202, 1}, {0x0190, 1, 203, 1}, {0x0191, 1, 1, 1}, {0x0193, 1, 205, 1},
+    {0x0194, 1, 207, 1}, {0x0196, 1, 211, 1}, {0x0197, 1, 209, 1}, {0x0198, 1, 1, 1},
+    {0x019C, 1, 211, 1}, {0x019D, 1, 213, 1}, {0x019F, 1, 214, 1}, {0x01A0, 3, 1, 2},
+    {0x01A6, 1, 218, 1}, {0x01A7, 1, 1, 1}, {0x01A9, 1, 218, 1}, {0x01AC, 1, 1, 1},
+    {0x01AE, 1, 218, 1}, {0x01AF, 1, 1, 1}, {0x01B1, 2, 217, 1}, {0x01B3, 2, 1, 2},
+    {0x01B7, 1, 219, 1}, {0x01B8, 1, 1, 1}, {0x01BC, 1, 1, 1}, {0x01C4, 1, 2, 1}, {0x01C5, 1, 1, 1},
+    {0x01C7, 1, 2, 1}, {0x01C8, 1, 1, 1}, {0x01CA, 1, 2, 1}, {0x01CB, 9, 1, 2}, {0x01DE, 9, 1, 2},
+    {0x01F1, 1, 2, 1}, {0x01F2, 2, 1, 2}, {0x01F6, 1, -97, 1}, {0x01F7, 1, -56, 1},
+    {0x01F8, 20, 1, 2}, {0x0220, 1, -130, 1}, {0x0222, 9, 1, 2}, {0x023B, 1, 1, 1},
+    {0x023D, 1, -163, 1}, {0x0241, 1, 1, 1}, {0x0243, 1, -195, 1}, {0x0244, 1, 69, 1},
+    {0x0245, 1, 71, 1}, {0x0246, 5, 1, 2}, {0x0345, 1, 116, 1}, {0x0370, 2, 1, 2},
+    {0x0376, 1, 1, 1}, {0x037F, 1, 116, 1}, {0x0386, 1, 38, 1}, {0x0388, 3, 37, 1},
+    {0x038C, 1, 64, 1}, {0x038E, 2, 63, 1}, {0x0391, 17, 32, 1}, {0x03A3, 9, 32, 1},
+    {0x03C2, 1, 1, 1}, {0x03CF, 1, 8, 1}, {0x03D0, 1, -30, 1}, {0x03D1, 1, -25, 1},
+    {0x03D5, 1, -15, 1}, {0x03D6, 1, -22, 1}, {0x03D8, 12, 1, 2}, {0x03F0, 1, -54, 1},
+    {0x03F1, 1, -48, 1}, {0x03F4, 1, -60, 1}, {0x03F5, 1, -64, 1}, {0x03F7, 1, 1, 1},
+    {0x03F9, 1, -7, 1}, {0x03FA, 1, 1, 1}, {0x03FD, 3, -130, 1}, {0x0400, 16, 80, 1},
+    {0x0410, 32, 32, 1}, {0x0460, 17, 1, 2}, {0x048A, 27, 1, 2}, {0x04C0, 1, 15, 1},
+    {0x04C1, 7, 1, 2}, {0x04D0, 48, 1, 2}, {0x0531, 38, 48, 1}, {0x10A0, 38, 7264, 1},
+    {0x10C7, 1, 7264, 1}, {0x10CD, 1, 7264, 1}, {0x13F8, 6, -8, 1}, {0x1C88, 1, 35267, 1},
+    {0x1C90, 43, -3008, 1}, {0x1CBD, 3, -3008, 1}, {0x1E00, 75, 1, 2}, {0x1E9B, 1, -58, 1},
+    {0x1EA0, 48, 1, 2}, {0x1F08, 8, -8, 1}, {0x1F18, 6, -8, 1}, {0x1F28, 8, -8, 1},
+    {0x1F38, 8, -8, 1}, {0x1F48, 6, -8, 1}, {0x1F59, 4, -8, 2}, {0x1F68, 8, -8, 1},
+    {0x1F88, 8, -8, 1}, {0x1F98, 8, -8, 1}, {0x1FA8, 8, -8, 1}, {0x1FB8, 2, -8, 1},
+    {0x1FBA, 2, -74, 1}, {0x1FBC, 1, -9, 1}, {0x1FC8, 4, -86, 1}, {0x1FCC, 1, -9, 1},
+    {0x1FD8, 2, -8, 1}, {0x1FDA, 2, -100, 1}, {0x1FE8, 2, -8, 1}, {0x1FEA, 2, -112, 1},
+    {0x1FEC, 1, -7, 1}, {0x1FF8, 2, -128, 1}, {0x1FFA, 2, -126, 1}, {0x1FFC, 1, -9, 1},
+    {0x2132, 1, 28, 1}, {0x2160, 16, 16, 1}, {0x2183, 1, 1, 1}, {0x24B6, 26, 26, 1},
+    {0x2C00, 48, 48, 1}, {0x2C60, 1, 1, 1}, {0x2C63, 1, -3814, 1}, {0x2C67, 3, 1, 2},
+    {0x2C72, 1, 1, 1}, {0x2C75, 1, 1, 1}, {0x2C80, 50, 1, 2}, {0x2CEB, 2, 1, 2}, {0x2CF2, 1, 1, 1},
+    {0xA640, 23, 1, 2}, {0xA680, 14, 1, 2}, {0xA722, 7, 1, 2}, {0xA732, 31, 1, 2},
+    {0xA779, 2, 1, 2}, {0xA77D, 1, -35332, 1}, {0xA77E, 5, 1, 2}, {0xA78B, 1, 1, 1},
+    {0xA790, 2, 1, 2}, {0xA796, 10, 1, 2}, {0xA7B3, 1, 928, 1}, {0xA7B4, 8, 1, 2},
+    {0xA7C4, 1, -48, 1}, {0xA7C6, 1, -35384, 1}, {0xA7C7, 2, 1, 2}, {0xA7D0, 1, 1, 1},
+    {0xA7D6, 2, 1, 2}, {0xA7F5, 1, 1, 1}, {0xAB70, 80, -38864, 1}, {0xFF21, 26, 32, 1}
+};
+
+inline uint32_t fold_codepoint(uint32_t cp) {
+    if (cp < 0x80) return (cp >= 'A' && cp <= 'Z') ? cp + 32 : cp;
+
+    // Last range starting at or before cp
+    size_t lo = 0, hi = sizeof(UTF8_FOLD_RANGES) / sizeof(UTF8_FOLD_RANGES[0]);
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (UTF8_FOLD_RANGES[mid].first <= cp) lo = mid + 1; else hi = mid;
+    }
+    if (lo == 0) return cp;
+    const FoldRange& r = UTF8_FOLD_RANGES[lo - 1];
+    const uint32_t offset = cp - r.first;
+    if (offset % r.stride != 0 || offset / r.stride >= r.count) return cp;
+    return static_cast<uint32_t>(static_cast<int64_t>(cp) + r.delta);
+}
+
+// Decodes the sequence at p (avail bytes left, p[0] >= 0x80). Returns its
+// length, or 0 for a malformed or truncated sequence.
+inline int utf8_decode(const uint8_t* p, size_t avail, uint32_t& cp) {
+    int n;
+    if ((p[0] & 0xE0) == 0xC0) {
+        n = 2;
+        cp = p[0] & 0x1F;
+    } else if ((p[0] & 0xF0) == 0xE0) {
+        n = 3;
+        cp = p[0] & 0x0F;
+    } else if ((p[0] & 0xF8) == 0xF0) {
+        n = 4;
+        cp = p[0] & 0x07;
+    } else {
+        return 0;
+    }
+    if (static_cast<size_t>(n) > avail) return 0;
+    for (int k = 1; k < n; k++) {
+        if ((p[k] & 0xC0) != 0x80) return 0;
+        cp = (cp << 6) | (p[k] & 0x3F);
+    }
+    return n;
+}
+
+// Writes cp as an n-byte sequence (n as returned by utf8_decode)
+inline void utf8_encode(uint32_t cp, int n, uint8_t* out) {
+    static const uint8_t lead[5] = { 0, 0, 0xC0, 0xE0, 0xF0 };
+    for (int k = n - 1; k > 0; k--) {
+        out[k] = static_cast<uint8_t>(0x80 | (cp & 0x3F));
+        cp >>= 6;
+    }
+    out[0] = static_cast<uint8_t>(lead[n] | cp);
+}
+
+// Folds the multi-byte sequence at p into out (same length); returns its
+// length, or 0 if it is malformed and should be passed through as bytes
+inline int fold_utf8_char(const uint8_t* p, size_t avail, uint8_t* out) {
+    uint32_t cp;
+    const int n = utf8_decode(p, avail, cp);
+    if (n == 0) return 0;
+    utf8_encode(fold_codepoint(cp), n, out);
+    return n;
+}
+
+// Folds a whole UTF-8 string in place
+inline void fold_utf8(std::string& s) {
+    uint8_t* p = reinterpret_cast<uint8_t*>(&s[0]);
+    const size_t len = s.size();
+    for (size_t i = 0; i < len;) {
+        if (p[i] < 0x80) {
+            p[i] = static_cast<uint8_t>(fold_codepoint(p[i]));
+            i++;
+            continue;
+        }
+        uint8_t folded[4];
+        const int n = fold_utf8_char(p + i, len - i, folded);
+        if (n == 0) {
+            i++;
+            continue;
+        }
+        for (int k = 0; k < n; k++) p[i + k] = folded[k];
+        i += n;
+    }
+}
+
+#endif
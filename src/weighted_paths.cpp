@@ -0,0 +1,358 @@
+#include <Rcpp.h>
+#include <vector>
+#include <atomic>
+#include <limits>
+#include <cstring>
+#include <cstdint>
+#include <utility>
+#include "graph_csr.h"
+#include "parallel_utils.h"
+
+// Non-negative IEEE doubles sort in the same order as their bit patterns, so
+// distances can be handled as uint64 keys by the radix heap and by the
+// compare-and-swap relaxations in delta-stepping.
+static inline uint64_t distance_key(double d) {
+    uint64_t key;
+    std::memcpy(&key, &d, sizeof(key));
+    return key;
+}
+
+static inline double key_distance(uint64_t key) {
+    double d;
+    std::memcpy(&d, &key, sizeof(d));
+    return d;
+}
+
+static const uint64_t UNREACHED_KEY = 0x7FF0000000000000ULL;  // +Inf
+
+// Monotone radix heap: valid as long as no key smaller than the last popped
+// key is pushed, which always holds for Dijkstra with non-negative weights.
+class RadixHeap {
+private:
+    std::vector<std::pair<uint64_t, int>> buckets[65];
+    uint64_t last;
+    size_t count;
+
+    static int bucket_of(uint64_t key, uint64_t last) {
+        return key == last ? 0 : 64 - __builtin_clzll(key ^ last);
+    }
+
+public:
+    RadixHeap() : last(0), count(0) {}
+
+    bool empty() const { return count == 0; }
+
+    void clear() {
+        for (int i = 0; i < 65; i++) {
+            buckets[i].clear();
+        }
+        last = 0;
+        count = 0;
+    }
+
+    void push(uint64_t key, int node) {
+        buckets[bucket_of(key, last)].emplace_back(key, node);
+        count++;
+    }
+
+    std::pair<uint64_t, int> pop() {
+        if (buckets[0].empty()) {
+            int i = 1;
+            while (buckets[i].empty()) i++;
+
+            uint64_t new_last = buckets[i][0].first;
+            for (const auto& entry : buckets[i]) {
+                if (entry.first < new_last) new_last = entry.first;
+            }
+
+            // Every entry moves to a strictly lower bucket
+            for (const auto& entry : buckets[i]) {
+                buckets[bucket_of(entry.first, new_last)].push_back(entry);
+            }
+            buckets[i].clear();
+            last = new_last;
+        }
+
+        std::pair<uint64_t, int> top = buckets[0].back();
+        buckets[0].pop_back();
+        count--;
+        return top;
+    }
+};
+
+// Single source-target Dijkstra. dist must be all +Inf on entry and is
+// restored to that state on exit, so it can be reused across queries
+// without an O(n) reset.
+static double dijkstra_pair(const CSRGraph& g, int source, int target, double max_distance,
+                            std::vector<double>& dist, std::vector<int>& touched,
+                            RadixHeap& heap) {
+    const double inf = std::numeric_limits<double>::infinity();
+    const bool limited = max_distance >= 0;
+    double answer = -1.0;
+
+    heap.clear();
+    dist[source] = 0.0;
+    touched.push_back(source);
+    heap.push(distance_key(0.0), source);
+
+    while (!heap.empty()) {
+        std::pair<uint64_t, int> top = heap.pop();
+        int u = top.second;
+        double du = key_distance(top.first);
+
+        if (du > dist[u]) continue;  // stale entry
+        if (u == target) {
+            answer = du;
+            break;
+        }
+
+        for (int64_t e = g.begin(u); e < g.end(u); e++) {
+            int v = g.targets[e];
+            double nd = du + g.weights[e];
+            if (limited && nd > max_distance) continue;
+            if (nd < dist[v]) {
+                if (dist[v] == inf) touched.push_back(v);
+                dist[v] = nd;
+                heap.push(distance_key(nd), v);
+            }
+        }
+    }
+
+    for (int v : touched) {
+        dist[v] = inf;
+    }
+    touched.clear();
+
+    return answer;
+}
+
+// Relax the light (w <= delta) or heavy (w > delta) edges leaving `nodes`.
+// Successful relaxations are collected per thread and then filed into their
+// buckets on the calling thread.
+static void delta_relax(const CSRGraph& g, const std::vector<int>& nodes, bool light,
+                        double delta, double max_distance,
+                        std::vector<std::atomic<uint64_t>>& dist,
+                        std::vector<std::vector<int>>& buckets,
+                        std::vector<std::vector<std::pair<int, double>>>& local,
+                        int n_threads) {
+    const bool limited = max_distance >= 0;
+    const int64_t n = static_cast<int64_t>(nodes.size());
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(n_threads) schedule(dynamic, 64)
+#endif
+    for (int64_t i = 0; i < n; i++) {
+        std::vector<std::pair<int, double>>& out = local[current_thread()];
+        int u = nodes[i];
+        double du = key_distance(dist[u].load(std::memory_order_relaxed));
+
+        for (int64_t e = g.begin(u); e < g.end(u); e++) {
+            double w = g.weights[e];
+            if ((w <= delta) != light) continue;
+
+            double nd = du + w;
+            if (limited && nd > max_distance) continue;
+
+            int v = g.targets[e];
+            uint64_t new_key = distance_key(nd);
+            uint64_t cur = dist[v].load(std::memory_order_relaxed);
+            while (new_key < cur) {
+                if (dist[v].compare_exchange_weak(cur, new_key, std::memory_order_relaxed)) {
+                    out.emplace_back(v, nd);
+                    break;
+                }
+            }
+        }
+    }
+
+    for (auto& out : local) {
+        for (const auto& req : out) {
+            size_t b = static_cast<size_t>(req.second / delta);
+            if (b >= buckets.size()) buckets.resize(b + 1);
+            buckets[b].push_back(req.first);
+        }
+        out.clear();
+    }
+}
+
+// Single-source delta-stepping (Meyer & Sanders). Returns the distance of
+// every node, +Inf where unreachable or beyond max_distance.
+static std::vector<double> delta_stepping(const CSRGraph& g, int source, double max_distance,
+                                          double delta, int n_threads) {
+    const int n = g.n_nodes;
+    std::vector<std::atomic<uint64_t>> dist(n);
+    for (int i = 0; i < n; i++) {
+        dist[i].store(UNREACHED_KEY, std::memory_order_relaxed);
+    }
+    dist[source].store(distance_key(0.0), std::memory_order_relaxed);
+
+    std::vector<std::vector<int>> buckets(1, std::vector<int>(1, source));
+    std::vector<std::vector<std::pair<int, double>>> local(n_threads);
+    std::vector<int> stamp(n, -1);
+    int round = 0;
+
+    for (size_t b = 0; b < buckets.size(); b++) {
+        std::vector<int> settled;
+
+        while (!buckets[b].empty()) {
+            std::vector<int> frontier;
+            frontier.swap(buckets[b]);
+
+            // Drop stale entries (node has since moved to a lower bucket)
+            // and duplicates within this round
+            round++;
+            size_t kept = 0;
+            for (size_t i = 0; i < frontier.size(); i++) {
+                int v = frontier[i];
+                double dv = key_distance(dist[v].load(std::memory_order_relaxed));
+                if (stamp[v] != round && static_cast<size_t>(dv / delta) == b) {
+                    stamp[v] = round;
+                    frontier[kept++] = v;
+                }
+            }
+            frontier.resize(kept);
+
+            settled.insert(settled.end(), frontier.begin(), frontier.end());
+            delta_relax(g, frontier, true, delta, max_distance, dist, buckets, local, n_threads);
+        }
+
+        round++;
+        size_t kept = 0;
+        for (size_t i = 0; i < settled.size(); i++) {
+            int v = settled[i];
+            if (stamp[v] != round) {
+                stamp[v] = round;
+                settled[kept++] = v;
+            }
+        }
+        settled.resize(kept);
+
+        delta_relax(g, settled, false, delta, max_distance, dist, buckets, local, n_threads);
+        std::vector<int>().swap(buckets[b]);
+    }
+
+    std::vector<double> result(n);
+    for (int i = 0; i < n; i++) {
+        result[i] = key_distance(dist[i].load(std::memory_order_relaxed));
+    }
+    return result;
+}
+
+static void check_weights(const Rcpp::IntegerMatrix& edges, const Rcpp::NumericVector& weights) {
+    if (weights.size() != edges.nrow()) {
+        Rcpp::stop("weights must have one entry per edge");
+    }
+    for (R_xlen_t i = 0; i < weights.size(); i++) {
+        if (!(weights[i] >= 0) || weights[i] == std::numeric_limits<double>::infinity()) {
+            Rcpp::stop("weights must be finite and non-negative");
+        }
+    }
+}
+
+static CSRGraph build_weighted_csr(const Rcpp::IntegerMatrix& edges, const Rcpp::NumericVector& weights,
+                                   int n_nodes) {
+    const int* from = edges.begin();
+    const int* to = from + edges.nrow();
+    CSRGraph g = build_csr(from, to, edges.nrow(), n_nodes, weights.begin());
+
+    // -0.0 would break the bit-pattern ordering of distance keys
+    for (double& w : g.weights) {
+        if (w == 0.0) w = 0.0;
+    }
+    return g;
+}
+
+//' Weighted Shortest Paths (Radix-Heap Dijkstra)
+//'
+//' Point-to-point weighted distances on an undirected graph. Each query runs
+//' Dijkstra with a monotone radix heap and stops as soon as the target is
+//' settled. Distance buffers are shared across queries and reset sparsely.
+//'
+//' @param edges IntegerMatrix with two columns (from, to)
+//' @param weights Non-negative edge weights, one per row of edges
+//' @param query_pairs IntegerMatrix of (source, target) pairs
+//' @param n_nodes Number of nodes in the graph
+//' @param max_distance Weighted distance cutoff; negative means no limit
+//' @return Numeric vector of distances, -1 where unreachable or beyond the cutoff
+// [[Rcpp::export]]
+Rcpp::NumericVector weighted_shortest_paths_cpp(const Rcpp::IntegerMatrix& edges,
+                                                const Rcpp::NumericVector& weights,
+                                                const Rcpp::IntegerMatrix& query_pairs,
+                                                int n_nodes, double max_distance = -1) {
+    check_weights(edges, weights);
+    CSRGraph g = build_weighted_csr(edges, weights, n_nodes);
+
+    const double inf = std::numeric_limits<double>::infinity();
+    std::vector<double> dist(n_nodes, inf);
+    std::vector<int> touched;
+    RadixHeap heap;
+
+    Rcpp::NumericVector result(query_pairs.nrow());
+
+    for (int q = 0; q < query_pairs.nrow(); q++) {
+        int source = query_pairs(q, 0) - 1;
+        int target = query_pairs(q, 1) - 1;
+
+        if (source < 0 || source >= n_nodes || target < 0 || target >= n_nodes) {
+            result[q] = -1;
+            continue;
+        }
+
+        if (source == target) {
+            result[q] = 0;
+            continue;
+        }
+
+        result[q] = dijkstra_pair(g, source, target, max_distance, dist, touched, heap);
+
+        if ((q & 1023) == 0) {
+            Rcpp::checkUserInterrupt();
+        }
+    }
+
+    return result;
+}
+
+//' Single-Source Weighted Distances (Parallel Delta-Stepping)
+//'
+//' Weighted distances from one source to every node of an undirected graph.
+//' Nodes are processed in distance buckets of width delta; light edges
+//' inside a bucket and heavy edges leaving it are relaxed in parallel.
+//'
+//' @param edges IntegerMatrix with two columns (from, to)
+//' @param weights Non-negative edge weights, one per row of edges
+//' @param source Source node (1-based)
+//' @param n_nodes Number of nodes in the graph
+//' @param max_distance Weighted distance cutoff; negative means no limit
+//' @param delta Bucket width. Values <= 0 pick the mean edge weight.
+//' @param n_threads Number of threads; <= 0 uses all available
+//' @return Numeric vector of length n_nodes, -1 where unreachable or beyond the cutoff
+// [[Rcpp::export]]
+Rcpp::NumericVector delta_stepping_cpp(const Rcpp::IntegerMatrix& edges,
+                                       const Rcpp::NumericVector& weights,
+                                       int source, int n_nodes,
+                                       double max_distance = -1, double delta = 0,
+                                       int n_threads = 0) {
+    check_weights(edges, weights);
+    if (source < 1 || source > n_nodes) {
+        Rcpp::stop("source must be a node ID between 1 and n_nodes");
+    }
+
+    CSRGraph g = build_weighted_csr(edges, weights, n_nodes);
+
+    if (!(delta > 0)) {
+        double total = 0.0;
+        for (double w : g.weights) total += w;
+        delta = g.weights.empty() ? 1.0 : total / g.weights.size();
+        if (!(delta > 0)) delta = 1.0;
+    }
+
+    std::vector<double> dist = delta_stepping(g, source - 1, max_distance, delta,
+                                              resolve_threads(n_threads));
+
+    Rcpp::NumericVector result(n_nodes);
+    for (int i = 0; i < n_nodes; i++) {
+        result[i] = (dist[i] == std::numeric_limits<double>::infinity()) ? -1.0 : dist[i];
+    }
+    return result;
+}